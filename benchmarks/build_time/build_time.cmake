@@ -0,0 +1,38 @@
+# Build-time comparison of the ways to consume tricky. Generates
+# TRICKY_BUILD_TIME_UNITS translation units from build_time_tu.cpp.in and
+# builds them as:
+#   build_time_header - every unit includes <tricky/tricky.h>
+#   build_time_pch    - the same units reusing tricky_pch (TRICKY_PCH=ON)
+#   build_time_module - every unit imports tricky (TRICKY_MODULE=ON)
+# Time a clean build of each target, e.g.
+#   cmake --build <dir> --target build_time_header --clean-first
+set(TRICKY_BUILD_TIME_UNITS 64 CACHE STRING "Number of translation units of the build_time_* targets")
+
+function(tricky_add_build_time_target TARGET PRELUDE)
+  set(sources)
+  foreach(TU_INDEX RANGE 1 ${TRICKY_BUILD_TIME_UNITS})
+    set(TU_PRELUDE "${PRELUDE}")
+    set(source ${CMAKE_CURRENT_BINARY_DIR}/${TARGET}/unit_${TU_INDEX}.cpp)
+    configure_file(${CMAKE_CURRENT_SOURCE_DIR}/build_time/build_time_tu.cpp.in
+                   ${source} @ONLY)
+    list(APPEND sources ${source})
+  endforeach()
+  add_library(${TARGET} STATIC ${sources})
+  set_target_properties(${TARGET} PROPERTIES
+    FOLDER benchmarks/build_time
+    EXCLUDE_FROM_ALL ON
+    )
+endfunction()
+
+tricky_add_build_time_target(build_time_header "#include <tricky/tricky.h>")
+target_link_libraries(build_time_header PRIVATE tricky)
+
+if(TARGET tricky_pch)
+  tricky_add_build_time_target(build_time_pch "#include <tricky/tricky.h>")
+  tricky_reuse_pch(build_time_pch)
+endif()
+
+if(TARGET tricky_module)
+  tricky_add_build_time_target(build_time_module "import tricky;")
+  target_link_libraries(build_time_module PRIVATE tricky_module)
+endif()
@@ -0,0 +1,24 @@
+# Prints the size of every symbol of BINARY whose demangled name matches
+# PATTERN. Usage:
+#   cmake -DNM=<nm> -DBINARY=<file> -DPATTERN=<regex> -P code_size.cmake
+execute_process(
+  COMMAND ${NM} -C --print-size --size-sort --radix=d ${BINARY}
+  OUTPUT_VARIABLE symbols
+  RESULT_VARIABLE nm_result
+  )
+if(NOT nm_result EQUAL 0)
+  message(WARNING "code size: ${NM} failed on ${BINARY}")
+  return()
+endif()
+
+string(REPLACE "\n" ";" symbols "${symbols}")
+foreach(line IN LISTS symbols)
+  if(line MATCHES "^[0-9]+ ([0-9]+) [tTwW] (.*)$")
+    set(size "${CMAKE_MATCH_1}")
+    set(name "${CMAKE_MATCH_2}")
+    if(name MATCHES "${PATTERN}")
+      math(EXPR size "${size}")
+      message(STATUS "code size: ${size} bytes ${name}")
+    endif()
+  endif()
+endforeach()
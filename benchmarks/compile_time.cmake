@@ -0,0 +1,25 @@
+# Prints the number of template instantiations and the front-end time recorded
+# by clang -ftime-trace in the *.json traces found under TRACE_DIR. Usage:
+#   cmake -DTRACE_DIR=<dir> -P compile_time.cmake
+file(GLOB_RECURSE traces "${TRACE_DIR}/*.json")
+if(NOT traces)
+  message(WARNING "compile time: no -ftime-trace output in ${TRACE_DIR}")
+  return()
+endif()
+
+foreach(trace IN LISTS traces)
+  file(READ "${trace}" content)
+  string(REGEX MATCHALL "\"name\":\"InstantiateClass\"" classes "${content}")
+  string(REGEX MATCHALL "\"name\":\"InstantiateFunction\"" functions "${content}")
+  list(LENGTH classes class_count)
+  list(LENGTH functions function_count)
+  set(frontend_us 0)
+  if(content MATCHES "\"dur\":([0-9]+),\"name\":\"Total Frontend\"")
+    set(frontend_us "${CMAKE_MATCH_1}")
+  endif()
+  math(EXPR frontend_ms "${frontend_us} / 1000")
+  get_filename_component(name "${trace}" NAME)
+  message(STATUS "compile time: ${name}: ${class_count} class and "
+                 "${function_count} function instantiations, "
+                 "front end ${frontend_ms} ms")
+endforeach()
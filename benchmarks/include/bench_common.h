@@ -0,0 +1,38 @@
+#ifndef tricky_bench_common_h
+#define tricky_bench_common_h
+
+#include <tricky/tricky.h>
+
+#include <cstdint>
+
+namespace bench_utils
+{
+enum class eReaderError : std::uint8_t
+{
+    kError1,
+    kError2,
+};
+
+enum class eWriterError : std::uint8_t
+{
+    kError3,
+    kError4,
+    kError5,
+};
+
+enum class eFileError : std::uint8_t
+{
+    kOpenError,
+    kEOF,
+    kAccessDenied,
+    kPermission,
+    kBusyDescriptor,
+    kFileNotFound,
+    kSystemError
+};
+
+template <typename T>
+using result = tricky::result<T, eReaderError, eWriterError, eFileError>;
+}  // namespace bench_utils
+
+#endif /* tricky_bench_common_h */
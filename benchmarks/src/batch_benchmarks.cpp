@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+#include <tricky/batch.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "bench_common.h"
+
+namespace
+{
+using namespace bench_utils;
+
+// A vector<result<...>> can not hold more than one error at a time because
+// result<...> keeps it in shared_state, so the per-record baseline is
+// inline_result<...>.
+using record = tricky::inline_result<int, eReaderError, eFileError>;
+using batch = tricky::result_batch<int, eReaderError, eFileError>;
+
+const auto to_int = tricky::handlers(
+    tricky::handler<eFileError>([](eFileError aError) noexcept
+                                { return -static_cast<int>(aError); }),
+    tricky::handler([](auto) noexcept { return -1; }));
+
+// Lane i fails when its hash falls below the error rate in per mille.
+bool fails(std::size_t aLane, std::int64_t aPerMille) noexcept
+{
+    const std::uint64_t hash = aLane * 0x9E3779B97F4A7C15ull;
+    return static_cast<std::int64_t>((hash >> 40) % 1000) < aPerMille;
+}
+
+void BM_VectorOfResults(benchmark::State &aState)
+{
+    const auto size = static_cast<std::size_t>(aState.range(0));
+    std::vector<record> records;
+    records.reserve(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        if (fails(i, aState.range(1)))
+        {
+            records.emplace_back(eFileError::kEOF);
+        }
+        else
+        {
+            records.emplace_back(static_cast<int>(i));
+        }
+    }
+    std::vector<int> out(size);
+    for (auto _ : aState)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            out[i] = to_int(record(records[i]));
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    aState.SetItemsProcessed(aState.iterations() * aState.range(0));
+}
+
+void BM_ResultBatch(benchmark::State &aState)
+{
+    const auto size = static_cast<std::size_t>(aState.range(0));
+    batch b;
+    b.reserve(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        if (fails(i, aState.range(1)))
+        {
+            b.push_error(eFileError::kEOF);
+        }
+        else
+        {
+            b.push_value(static_cast<int>(i));
+        }
+    }
+    std::vector<int> out(size);
+    for (auto _ : aState)
+    {
+        b.handle_all(to_int, out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    aState.SetItemsProcessed(aState.iterations() * aState.range(0));
+}
+
+// records x error rate in per mille
+void arguments(benchmark::internal::Benchmark *aBenchmark)
+{
+    aBenchmark->ArgNames({"records", "errors_per_mille"});
+    for (std::int64_t records: {1 << 10, 1 << 16, 1 << 20})
+    {
+        for (std::int64_t per_mille: {0, 10, 100})
+        {
+            aBenchmark->Args({records, per_mille});
+        }
+    }
+}
+}  // namespace
+
+BENCHMARK(BM_VectorOfResults)->Apply(arguments);
+BENCHMARK(BM_ResultBatch)->Apply(arguments);
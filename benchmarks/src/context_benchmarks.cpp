@@ -0,0 +1,254 @@
+// Moves of contexts through a chain of stages, with and without a pending
+// error. relocatable_context moves its error with a memcpy, tracked_context
+// holds an error type which is not trivially copyable and moves it through
+// tricky::error.
+//
+// Churn of heavy contexts, one per request: a payload buffer allocated per
+// request against contexts recycled by context_pool.
+//
+// Nested context_activator scopes of depth 1..16 through a base reference:
+// the stack of polymorphic_context against virtual activation which keeps
+// one pointer per thread.
+//
+// An error raised in the innermost of 8 nested contexts and forwarded to
+// the outermost one, against the same scopes without an error.
+#include <benchmark/benchmark.h>
+#include <cargo/cargo.h>
+#include <tricky/context.h>
+#include <tricky/context_pool.h>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "bench_common.h"
+
+namespace
+{
+using namespace bench_utils;
+
+struct tracked_error
+{
+    tracked_error() noexcept = default;
+    tracked_error(const tracked_error &aOther) noexcept : code(aOther.code) {}
+
+    int code{};
+};
+
+using relocatable_context = tricky::context<eReaderError, eFileError>;
+using tracked_context = tricky::context<eFileError, tracked_error>;
+
+inline constexpr int kMoves = 10;
+
+template <typename Ctx>
+Ctx stage(Ctx &&aCtx, int aDepth) noexcept
+{
+    Ctx ctx(std::move(aCtx));
+    benchmark::DoNotOptimize(ctx);
+    if (aDepth > 1)
+    {
+        return stage(std::move(ctx), aDepth - 1);
+    }
+    return ctx;
+}
+
+template <typename Ctx, bool Pending>
+void BM_MoveChain(benchmark::State &aState)
+{
+    for (auto _ : aState)
+    {
+        Ctx ctx;
+        if constexpr (Pending)
+        {
+            tricky::details::ctx::set_error(eFileError::kEOF, ctx);
+        }
+        Ctx last = stage(std::move(ctx), kMoves);
+        if constexpr (Pending)
+        {
+            tricky::details::ctx::reset_error(last);
+        }
+    }
+    aState.counters["moves"] = kMoves;
+}
+
+using request_context =
+    tricky::heavy_context<cargo::payload, eReaderError, eFileError>;
+using request_pool = tricky::context_pool<request_context>;
+
+inline constexpr std::size_t kRequestPayload = request_pool::payload_size;
+
+template <typename Ctx>
+void serve(Ctx &aCtx, int aRequest) noexcept
+{
+    aCtx.payload().load(aRequest);
+    if (aRequest % 64 == 0)
+    {
+        tricky::details::ctx::set_error(eFileError::kEOF, aCtx);
+        tricky::details::ctx::reset_error(aCtx);
+    }
+    benchmark::DoNotOptimize(aCtx);
+}
+
+void BM_ChurnBuffer(benchmark::State &aState)
+{
+    int request = 0;
+    for (auto _ : aState)
+    {
+        auto buffer = std::make_unique<char[]>(kRequestPayload);
+        request_context ctx(buffer.get(), kRequestPayload);
+        serve(ctx, ++request);
+    }
+    aState.counters["allocs"] = 1;
+}
+
+void BM_ChurnPool(benchmark::State &aState)
+{
+    const std::size_t before = request_pool::allocated();
+    int request = 0;
+    for (auto _ : aState)
+    {
+        auto ctx = request_pool::acquire();
+        serve(*ctx, ++request);
+    }
+    // contexts allocated per request, goes to zero with the iterations;
+    // the pool counts for all threads, so only one of them reports
+    if (aState.thread_index() == 0)
+    {
+        aState.counters["allocs"] = benchmark::Counter(
+            static_cast<double>(request_pool::allocated() - before),
+            benchmark::Counter::kAvgIterations);
+    }
+}
+
+// activation as polymorphic_context did it with virtual calls
+class virtual_context
+{
+   public:
+    virtual bool is_active() const noexcept = 0;
+    virtual void activate() noexcept = 0;
+    virtual void deactivate() noexcept = 0;
+
+   protected:
+    ~virtual_context() noexcept = default;
+
+    static inline thread_local virtual_context *active_context_{nullptr};
+};
+
+template <typename Context>
+struct virtual_context_impl final
+    : virtual_context
+    , Context
+{
+    bool is_active() const noexcept override { return this == active_context_; }
+
+    void activate() noexcept override { active_context_ = this; }
+
+    void deactivate() noexcept override { active_context_ = nullptr; }
+};
+
+inline constexpr std::size_t kMaxDepth = 16;
+
+template <typename Base>
+void enter(std::array<Base *, kMaxDepth> &aContexts, std::size_t aDepth)
+{
+    tricky::context_activator<Base> activator(*aContexts[aDepth - 1]);
+    benchmark::DoNotOptimize(activator);
+    if (aDepth > 1)
+    {
+        enter(aContexts, aDepth - 1);
+    }
+}
+
+template <typename Base, typename Impl>
+void BM_NestedActivation(benchmark::State &aState)
+{
+    const auto depth = static_cast<std::size_t>(aState.range(0));
+    std::array<Impl, kMaxDepth> contexts;
+    std::array<Base *, kMaxDepth> bases{};
+    for (std::size_t i = 0; i < kMaxDepth; ++i)
+    {
+        bases[i] = &contexts[i];
+    }
+    for (auto _ : aState)
+    {
+        enter(bases, depth);
+    }
+    aState.counters["depth"] = static_cast<double>(depth);
+}
+
+using stacked_context =
+    tricky::details::polymorphic_context_impl<relocatable_context>;
+using virtual_activation = virtual_context_impl<relocatable_context>;
+
+struct snapshot
+{
+    std::array<std::uint64_t, 8> words;
+};
+
+// spills out of the inline buffer, forwarding moves the pointer only
+using snapshot_context = tricky::context<eFileError, snapshot>;
+
+inline constexpr std::size_t kForwardDepth = 8;
+
+template <typename Context>
+using forward_contexts =
+    std::array<tricky::details::polymorphic_context_impl<Context>,
+               kForwardDepth>;
+
+// activates the contexts from the outermost, aContexts.back(), to the
+// innermost, aContexts.front(), which raises aError if any
+template <typename Context, typename E>
+void raise_in(forward_contexts<Context> &aContexts, std::size_t aDepth,
+              const E *aError)
+{
+    auto &ctx = aContexts[aDepth - 1];
+    tricky::context_activator<std::remove_reference_t<decltype(ctx)>>
+        activator(ctx);
+    if (aDepth > 1)
+    {
+        raise_in<Context>(aContexts, aDepth - 1, aError);
+    }
+    else if (aError)
+    {
+        tricky::details::ctx::set_error(*aError, static_cast<Context &>(ctx));
+    }
+}
+
+template <typename Context, typename E, bool Raise>
+void BM_Forward(benchmark::State &aState)
+{
+    forward_contexts<Context> contexts;
+    const E error{};
+    for (auto _ : aState)
+    {
+        raise_in<Context>(contexts, kForwardDepth, Raise ? &error : nullptr);
+        if constexpr (Raise)
+        {
+            tricky::details::ctx::reset_error(
+                static_cast<Context &>(contexts.back()));
+        }
+    }
+    aState.counters["levels"] = kForwardDepth;
+}
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_NestedActivation, tricky::polymorphic_context,
+                   stacked_context)
+    ->DenseRange(1, kMaxDepth);
+BENCHMARK_TEMPLATE(BM_NestedActivation, virtual_context, virtual_activation)
+    ->DenseRange(1, kMaxDepth);
+
+BENCHMARK_TEMPLATE(BM_Forward, relocatable_context, eFileError, false);
+BENCHMARK_TEMPLATE(BM_Forward, relocatable_context, eFileError, true);
+BENCHMARK_TEMPLATE(BM_Forward, snapshot_context, snapshot, false);
+BENCHMARK_TEMPLATE(BM_Forward, snapshot_context, snapshot, true);
+
+BENCHMARK(BM_ChurnBuffer)->ThreadRange(1, 8);
+BENCHMARK(BM_ChurnPool)->ThreadRange(1, 8);
+
+BENCHMARK_TEMPLATE(BM_MoveChain, relocatable_context, false);
+BENCHMARK_TEMPLATE(BM_MoveChain, relocatable_context, true);
+BENCHMARK_TEMPLATE(BM_MoveChain, tracked_context, false);
+BENCHMARK_TEMPLATE(BM_MoveChain, tracked_context, true);
@@ -0,0 +1,128 @@
+#include <benchmark/benchmark.h>
+#include <tricky/coroutine.h>
+
+#include <coroutine>
+#include <exception>
+
+#include "bench_common.h"
+
+namespace
+{
+using namespace bench_utils;
+
+// Suspends and is resumed immediately by symmetric transfer, so every
+// co_await costs one suspension and one resumption.
+struct resume_self
+{
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<> aHandle) const noexcept
+    {
+        return aHandle;
+    }
+    void await_resume() const noexcept {}
+};
+
+// Eager coroutine without error state handling: the baseline for task<>.
+struct bare_coroutine
+{
+    struct promise_type
+    {
+        bare_coroutine get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+result<int> produce(int aValue) noexcept { return aValue; }
+
+result<int> (*volatile producer)(int) noexcept = &produce;
+
+result<int> call_plain(int aValue) noexcept
+{
+    TRICKY_AUTO(value, producer(aValue));
+    return value + 1;
+}
+
+tricky::task<result<int>> produce_task(int aValue) { co_return aValue; }
+
+bare_coroutine resume_bare(benchmark::State &aState)
+{
+    for (auto _ : aState)
+    {
+        co_await resume_self{};
+    }
+    co_return;
+}
+
+tricky::task<result<int>> resume_task(benchmark::State &aState)
+{
+    for (auto _ : aState)
+    {
+        co_await resume_self{};
+    }
+    co_return 0;
+}
+
+tricky::task<result<int>> resume_task_with_error(benchmark::State &aState)
+{
+    // the error stays pending across every suspension
+    result<int> r{eFileError::kEOF};
+    for (auto _ : aState)
+    {
+        co_await resume_self{};
+        benchmark::DoNotOptimize(r.has_error());
+    }
+    co_return std::move(r);
+}
+
+tricky::task<result<int>> await_tasks(benchmark::State &aState)
+{
+    int sum = 0;
+    for (auto _ : aState)
+    {
+        TRICKY_CO_AUTO(value, co_await produce_task(sum & 1));
+        sum += value;
+        benchmark::DoNotOptimize(sum);
+    }
+    co_return sum;
+}
+
+const auto handle_any = tricky::handlers(
+    tricky::handler([](auto) noexcept { return 0; }));
+
+void BM_ResumeBare(benchmark::State &aState) { resume_bare(aState); }
+
+void BM_ResumeTask(benchmark::State &aState)
+{
+    handle_any(tricky::sync_wait(resume_task(aState)));
+}
+
+void BM_ResumeTaskWithError(benchmark::State &aState)
+{
+    handle_any(tricky::sync_wait(resume_task_with_error(aState)));
+}
+
+void BM_CallPlain(benchmark::State &aState)
+{
+    int sum = 0;
+    for (auto _ : aState)
+    {
+        sum += handle_any(call_plain(sum & 1));
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+void BM_AwaitTask(benchmark::State &aState)
+{
+    handle_any(tricky::sync_wait(await_tasks(aState)));
+}
+}  // namespace
+
+BENCHMARK(BM_ResumeBare);
+BENCHMARK(BM_ResumeTask);
+BENCHMARK(BM_ResumeTaskWithError);
+BENCHMARK(BM_CallPlain);
+BENCHMARK(BM_AwaitTask);
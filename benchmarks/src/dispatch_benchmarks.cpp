@@ -0,0 +1,189 @@
+#include <benchmark/benchmark.h>
+#include <tricky/tricky.h>
+
+#include "bench_common.h"
+
+#include <array>
+#include <utility>
+
+namespace
+{
+using namespace bench_utils;
+
+template <std::size_t I>
+struct category
+{
+    enum class type : std::uint8_t
+    {
+        kFirst,
+        kSecond
+    };
+};
+
+template <typename T, typename Indices>
+struct result_with;
+
+template <typename T, std::size_t... I>
+struct result_with<T, std::index_sequence<I...>>
+{
+    using type = tricky::basic_result<tricky::details::inline_layout, T,
+                                      typename category<I>::type...>;
+};
+
+template <typename T, std::size_t N>
+using result_t = typename result_with<T, std::make_index_sequence<N>>::type;
+
+template <std::size_t N>
+using last_error_t = typename category<N - 1>::type;
+
+template <std::size_t N>
+result_t<short, N> make_error() noexcept
+{
+    return last_error_t<N>::kSecond;
+}
+
+// Kept out of line so that nm reports the size of the conversion alone, see
+// code_size.cmake.
+template <std::size_t N>
+[[gnu::noinline]] result_t<int, N> convert(
+    result_t<short, N> &&aResult) noexcept
+{
+    return std::move(aResult);
+}
+
+template <std::size_t N>
+result_t<short, N> (*volatile producer)() noexcept = &make_error<N>;
+
+template <std::size_t N>
+void BM_ConvertLastError(benchmark::State &aState)
+{
+    std::size_t sum = 0;
+    for (auto _ : aState)
+    {
+        const auto r = convert<N>(producer<N>());
+        sum += r.type_index();
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+enum class eDenseError : std::uint8_t
+{
+};
+
+enum class eSparseError : std::uint32_t
+{
+};
+
+inline constexpr std::size_t kHandledValues = 16;
+
+template <typename E, std::size_t I>
+inline constexpr E kValueAt = static_cast<E>(
+    std::is_same_v<E, eDenseError> ? I : I * 16'777'619u);
+
+template <typename E>
+using handled_result = tricky::inline_result<int, eReaderError, E>;
+
+template <typename E, std::size_t... I>
+utils::value_list<kValueAt<E, I>...> make_value_list(
+    std::index_sequence<I...>) noexcept;
+
+template <typename E>
+using handled_values = tricky::details::sorted_values<
+    E, decltype(make_value_list<E>(
+           std::make_index_sequence<kHandledValues>{}))>;
+
+struct binary_search
+{
+    template <typename Values>
+    static constexpr std::size_t index_of(
+        typename Values::underlying_type aValue) noexcept
+    {
+        return Values::index_of(aValue);
+    }
+};
+
+struct perfect_hash
+{
+    template <typename Values>
+    static constexpr std::size_t index_of(
+        typename Values::underlying_type aValue) noexcept
+    {
+        return tricky::details::perfect_hash<Values>::index_of(aValue);
+    }
+};
+
+// Looks up every handled value and the same number of unhandled ones.
+template <typename Lookup>
+void BM_LookupSparseValue(benchmark::State &aState)
+{
+    using values = handled_values<eSparseError>;
+    std::array<std::uint32_t, 2 * kHandledValues> keys{};
+    for (std::size_t i = 0; i < kHandledValues; ++i)
+    {
+        keys[2 * i] = values::values[(i * 7) % kHandledValues];
+        keys[2 * i + 1] = keys[2 * i] + 1;
+    }
+    std::size_t i = 0;
+    std::size_t sum = 0;
+    for (auto _ : aState)
+    {
+        sum += Lookup::template index_of<values>(keys[i++ % keys.size()]);
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+template <typename E, std::size_t... I>
+constexpr auto make_handlers(std::index_sequence<I...>) noexcept
+{
+    return tricky::handlers(
+        tricky::handler<kValueAt<E, I>...>(
+            [](auto aError) noexcept { return static_cast<int>(aError); }),
+        tricky::handler([](auto) noexcept { return -1; }));
+}
+
+template <typename E>
+inline constexpr auto kHandlers =
+    make_handlers<E>(std::make_index_sequence<kHandledValues>{});
+
+// Kept out of line so that nm reports the size of the dispatch alone.
+template <typename E>
+[[gnu::noinline]] int handle(handled_result<E> &&aResult) noexcept
+{
+    return kHandlers<E>(std::move(aResult));
+}
+
+template <typename E, std::size_t... I>
+std::array<handled_result<E>, sizeof...(I)> make_errors(
+    std::index_sequence<I...>) noexcept
+{
+    return {handled_result<E>{kValueAt<E, (I * 7) % sizeof...(I)>}...};
+}
+
+template <typename E>
+void BM_HandleValue(benchmark::State &aState)
+{
+    const auto errors =
+        make_errors<E>(std::make_index_sequence<kHandledValues>{});
+    std::size_t i = 0;
+    int sum = 0;
+    for (auto _ : aState)
+    {
+        sum += handle<E>(handled_result<E>{errors[i++ % errors.size()]});
+        benchmark::DoNotOptimize(sum);
+    }
+}
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_HandleValue, eDenseError);
+BENCHMARK_TEMPLATE(BM_HandleValue, eSparseError);
+BENCHMARK_TEMPLATE(BM_LookupSparseValue, binary_search);
+BENCHMARK_TEMPLATE(BM_LookupSparseValue, perfect_hash);
+
+BENCHMARK_TEMPLATE(BM_ConvertLastError, 1);
+BENCHMARK_TEMPLATE(BM_ConvertLastError, 2);
+BENCHMARK_TEMPLATE(BM_ConvertLastError, 4);
+BENCHMARK_TEMPLATE(BM_ConvertLastError, 8);
+BENCHMARK_TEMPLATE(BM_ConvertLastError, 12);
+BENCHMARK_TEMPLATE(BM_ConvertLastError, 16);
+BENCHMARK_TEMPLATE(BM_ConvertLastError, 24);
+BENCHMARK_TEMPLATE(BM_ConvertLastError, 32);
@@ -0,0 +1,55 @@
+// Compile-time benchmark of value handler dispatch: build the
+// dispatch_compile_dense and dispatch_compile_sparse targets and compare
+// their compile times. Both instantiate handlers for kHandledValues values of
+// one category, either consecutive or far apart (TRICKY_BENCH_SPARSE).
+#include <benchmark/benchmark.h>
+#include <tricky/tricky.h>
+
+#include <utility>
+
+#include "bench_common.h"
+
+namespace
+{
+using namespace bench_utils;
+
+enum class eError : std::uint32_t
+{
+};
+
+inline constexpr std::size_t kHandledValues = 128;
+
+#ifdef TRICKY_BENCH_SPARSE
+inline constexpr std::uint32_t kStep = 16'777'619u;
+#else
+inline constexpr std::uint32_t kStep = 1;
+#endif
+
+template <std::size_t I>
+inline constexpr eError kValueAt = static_cast<eError>(I * kStep);
+
+using handled_result = tricky::inline_result<int, eReaderError, eError>;
+
+template <std::size_t... I>
+constexpr auto make_handlers(std::index_sequence<I...>) noexcept
+{
+    return tricky::handlers(
+        tricky::handler<kValueAt<I>...>(
+            [](auto aError) noexcept { return static_cast<int>(aError); }),
+        tricky::handler([](auto) noexcept { return -1; }));
+}
+
+void BM_HandleValue(benchmark::State &aState)
+{
+    constexpr auto kHandlers =
+        make_handlers(std::make_index_sequence<kHandledValues>{});
+    int sum = 0;
+    for (auto _ : aState)
+    {
+        sum += kHandlers(handled_result{kValueAt<kHandledValues / 2>});
+        benchmark::DoNotOptimize(sum);
+    }
+}
+}  // namespace
+
+BENCHMARK(BM_HandleValue);
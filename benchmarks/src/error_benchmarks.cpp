@@ -0,0 +1,95 @@
+// Size and move cost of contexts holding small enums and a rarely raised
+// large error. fat_context keeps every error inline, as before error_spill,
+// context spills the large one.
+#include <benchmark/benchmark.h>
+#include <tricky/context.h>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "bench_common.h"
+
+namespace
+{
+using namespace bench_utils;
+
+struct snapshot
+{
+    std::array<std::uint64_t, 32> words;
+};
+
+using context = tricky::context<eReaderError, eFileError, snapshot>;
+
+// every error inline: the layout of context before large errors spilled
+class fat_context
+{
+   public:
+    using error_t = tricky::error<sizeof(snapshot), alignof(snapshot)>;
+
+    template <typename E>
+    explicit fat_context(E aError) noexcept : error_(aError)
+    {
+    }
+
+    error_t error_;
+};
+
+template <typename Ctx, typename E>
+Ctx make_context(E aError) noexcept
+{
+    if constexpr (std::is_same_v<Ctx, fat_context>)
+    {
+        return Ctx(aError);
+    }
+    else
+    {
+        Ctx ctx;
+        tricky::details::ctx::set_error(aError, ctx);
+        return ctx;
+    }
+}
+
+template <typename Ctx>
+void release(Ctx &aCtx) noexcept
+{
+    if constexpr (!std::is_same_v<Ctx, fat_context>)
+    {
+        tricky::details::ctx::reset_error(aCtx);
+    }
+}
+
+template <typename Ctx, typename E>
+void move_chain(benchmark::State &aState, E aError)
+{
+    for (auto _ : aState)
+    {
+        Ctx ctx = make_context<Ctx>(aError);
+        Ctx moved1(std::move(ctx));
+        Ctx moved2(std::move(moved1));
+        Ctx moved3(std::move(moved2));
+        benchmark::DoNotOptimize(moved3);
+        release(moved3);
+    }
+    aState.counters["bytes"] = static_cast<double>(sizeof(Ctx));
+}
+
+template <typename Ctx>
+void BM_MoveSmallError(benchmark::State &aState)
+{
+    move_chain<Ctx>(aState, eFileError::kEOF);
+}
+
+template <typename Ctx>
+void BM_MoveLargeError(benchmark::State &aState)
+{
+    snapshot s{};
+    s.words[0] = 1;
+    move_chain<Ctx>(aState, s);
+}
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_MoveSmallError, fat_context);
+BENCHMARK_TEMPLATE(BM_MoveSmallError, context);
+BENCHMARK_TEMPLATE(BM_MoveLargeError, fat_context);
+BENCHMARK_TEMPLATE(BM_MoveLargeError, context);
@@ -0,0 +1,70 @@
+// Compile-time benchmark of a large handler set: kCategories error enums
+// with kValuesPerCategory handled values each, one values_handler per enum
+// plus an any-handler. package_report_compile_time() records the template
+// instantiations of this translation unit (see compile_time.cmake).
+#include <benchmark/benchmark.h>
+#include <tricky/tricky.h>
+
+#include <cstdint>
+#include <utility>
+
+namespace
+{
+inline constexpr std::size_t kCategories = 32;
+inline constexpr std::size_t kValuesPerCategory = 16;
+
+template <std::size_t C>
+struct category
+{
+    enum class type : std::uint32_t
+    {
+    };
+};
+
+template <std::size_t C>
+using category_t = typename category<C>::type;
+
+template <std::size_t C, std::size_t V>
+inline constexpr category_t<C> kValue = static_cast<category_t<C>>(V * 3);
+
+template <std::size_t C0, std::size_t... C>
+auto make_result_type(std::index_sequence<C0, C...>)
+    -> tricky::inline_result<int, category_t<C0>, category_t<C>...>;
+
+using handled_result = decltype(make_result_type(
+    std::make_index_sequence<kCategories>{}));
+
+template <std::size_t C, std::size_t... V>
+constexpr auto make_handler(std::index_sequence<V...>) noexcept
+{
+    return tricky::handler<kValue<C, V>...>(
+        [](auto aError) noexcept
+        {
+            return static_cast<int>(C * 1000 +
+                                    static_cast<std::size_t>(aError));
+        });
+}
+
+template <std::size_t... C>
+constexpr auto make_handlers(std::index_sequence<C...>) noexcept
+{
+    return tricky::handlers(
+        make_handler<C>(std::make_index_sequence<kValuesPerCategory>{})...,
+        tricky::handler([](auto) noexcept { return -1; }));
+}
+
+void BM_HandleLargeSet(benchmark::State &aState)
+{
+    constexpr auto kHandlers =
+        make_handlers(std::make_index_sequence<kCategories>{});
+    int sum = 0;
+    for (auto _ : aState)
+    {
+        sum += kHandlers(handled_result{kValue<kCategories / 2, 5>});
+        sum += kHandlers(handled_result{static_cast<category_t<3>>(1)});
+        benchmark::DoNotOptimize(sum);
+    }
+}
+}  // namespace
+
+BENCHMARK(BM_HandleLargeSet);
@@ -0,0 +1,78 @@
+// Built twice: payload_fixed_benchmarks keeps payloads in the fixed buffer
+// of details::state, payload_arena_benchmarks (TRICKY_PAYLOAD_ARENA) in the
+// payload arena.
+#include <benchmark/benchmark.h>
+#include <tricky/tricky.h>
+
+#include <array>
+
+#include "bench_common.h"
+
+namespace
+{
+using namespace bench_utils;
+
+template <std::size_t N>
+struct blob
+{
+    std::array<char, N> bytes;
+};
+
+template <std::size_t N>
+bool handle(result<int> &&aResult) noexcept
+{
+    bool stored = false;
+    const auto process = tricky::handlers(tricky::handler(
+        [&stored](auto) noexcept
+        {
+            tricky::process_payload([&stored](const blob<N> &aBlob) noexcept
+                                    { stored = aBlob.bytes[N - 1] == 'x'; });
+            return 0;
+        }));
+    process(std::move(aResult));
+    return stored;
+}
+
+void BM_SmallPayload(benchmark::State &aState)
+{
+    int value = 0;
+    for (auto _ : aState)
+    {
+        result<int> r{eFileError::kEOF, ++value, TRICKY_SOURCE_LOCATION};
+        benchmark::DoNotOptimize(r);
+        tricky::handlers(tricky::handler(
+            [](auto) noexcept
+            {
+                int loaded = 0;
+                tricky::process_payload(
+                    [&loaded](int aValue, const tricky::e_source_location &)
+                        noexcept { loaded = aValue; });
+                return loaded;
+            }))(std::move(r));
+    }
+}
+
+template <std::size_t N>
+void BM_LargePayload(benchmark::State &aState)
+{
+    blob<N> payload{};
+    payload.bytes[N - 1] = 'x';
+    std::size_t stored = 0;
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(payload);
+        stored += handle<N>(result<int>{eReaderError::kError2, payload});
+    }
+    // 1 when every payload reached the handler, 0 when all were cut off
+    aState.counters["stored"] =
+        static_cast<double>(stored) / static_cast<double>(aState.iterations());
+    aState.SetBytesProcessed(static_cast<std::int64_t>(aState.iterations()) *
+                             static_cast<std::int64_t>(N));
+}
+}  // namespace
+
+BENCHMARK(BM_SmallPayload);
+BENCHMARK_TEMPLATE(BM_LargePayload, 64);
+BENCHMARK_TEMPLATE(BM_LargePayload, 200);
+BENCHMARK_TEMPLATE(BM_LargePayload, 1024);
+BENCHMARK_TEMPLATE(BM_LargePayload, 4096);
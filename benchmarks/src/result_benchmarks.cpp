@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+#include <tricky/tricky.h>
+
+#include <vector>
+
+#include "bench_common.h"
+
+namespace
+{
+using namespace bench_utils;
+
+template <typename T>
+using inline_result =
+    tricky::inline_result<T, eReaderError, eWriterError, eFileError>;
+
+template <typename Result>
+Result produce(int aValue) noexcept
+{
+    return aValue;
+}
+
+// Calls through a volatile pointer so that the producer is never inlined and
+// the check after the call has to look at the real discriminant.
+template <typename Result>
+Result (*volatile producer)(int) noexcept = &produce<Result>;
+
+template <typename Result>
+void BM_CheckAndUnwrap(benchmark::State &aState)
+{
+    int input = 1;
+    int sum = 0;
+    for (auto _ : aState)
+    {
+        const Result r = producer<Result>(input);
+        if (r)
+        {
+            sum += r.value();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+template <typename Result>
+void BM_ScanStoredResults(benchmark::State &aState)
+{
+    std::vector<Result> results(static_cast<std::size_t>(aState.range(0)));
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        results[i] = Result(static_cast<int>(i));
+    }
+    for (auto _ : aState)
+    {
+        int sum = 0;
+        for (const auto &r: results)
+        {
+            if (r)
+            {
+                sum += r.value();
+            }
+            benchmark::ClobberMemory();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    aState.SetItemsProcessed(aState.iterations() * aState.range(0));
+}
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_CheckAndUnwrap, result<int>);
+BENCHMARK_TEMPLATE(BM_CheckAndUnwrap, inline_result<int>);
+BENCHMARK_TEMPLATE(BM_ScanStoredResults, result<int>)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_ScanStoredResults, inline_result<int>)->Arg(1024);
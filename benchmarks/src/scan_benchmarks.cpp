@@ -0,0 +1,159 @@
+// Built with TRICKY_SCAN_RUNTIME_DISPATCH, so the AVX2 kernels are measured
+// on any CPU that has them.
+#include <benchmark/benchmark.h>
+#include <tricky/scan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+using tricky::scan_isa;
+
+// indices of aSize lanes, aPerMille of them errors of 3 categories
+std::vector<std::uint8_t> make_indices(std::size_t aSize,
+                                       std::int64_t aPerMille)
+{
+    std::vector<std::uint8_t> indices(aSize);
+    for (std::size_t i = 0; i < aSize; ++i)
+    {
+        const std::uint64_t hash = i * 0x9E3779B97F4A7C15ull;
+        if (static_cast<std::int64_t>((hash >> 40) % 1000) < aPerMille)
+        {
+            indices[i] = static_cast<std::uint8_t>(1 + (hash >> 20) % 3);
+        }
+    }
+    return indices;
+}
+
+bool skip_unsupported(benchmark::State &aState, scan_isa aIsa)
+{
+    if (!tricky::scan_isa_supported(aIsa))
+    {
+        aState.SkipWithError("scan_isa is not supported");
+        return true;
+    }
+    return false;
+}
+
+void set_processed(benchmark::State &aState)
+{
+    aState.SetItemsProcessed(aState.iterations() * aState.range(0));
+}
+
+// no errors, so the whole array is scanned
+template <scan_isa Isa>
+void BM_ContainsError(benchmark::State &aState)
+{
+    if (skip_unsupported(aState, Isa))
+    {
+        return;
+    }
+    const auto indices =
+        make_indices(static_cast<std::size_t>(aState.range(0)), 0);
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(
+            tricky::contains_error(indices.data(), indices.size(), Isa));
+    }
+    set_processed(aState);
+}
+
+// the only error is in the last lane
+template <scan_isa Isa>
+void BM_FindFirstError(benchmark::State &aState)
+{
+    if (skip_unsupported(aState, Isa))
+    {
+        return;
+    }
+    auto indices = make_indices(static_cast<std::size_t>(aState.range(0)), 0);
+    indices.back() = 1;
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(
+            tricky::find_first_error(indices.data(), indices.size(), Isa));
+    }
+    set_processed(aState);
+}
+
+template <scan_isa Isa>
+void BM_CountIndices(benchmark::State &aState)
+{
+    if (skip_unsupported(aState, Isa))
+    {
+        return;
+    }
+    const auto indices =
+        make_indices(static_cast<std::size_t>(aState.range(0)), 100);
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(
+            tricky::count_indices<4>(indices.data(), indices.size(), Isa));
+    }
+    set_processed(aState);
+}
+
+template <scan_isa Isa>
+void BM_CompressValues(benchmark::State &aState)
+{
+    if (skip_unsupported(aState, Isa))
+    {
+        return;
+    }
+    const auto size = static_cast<std::size_t>(aState.range(0));
+    const auto indices = make_indices(size, aState.range(1));
+    std::vector<std::int32_t> values(size, 1);
+    std::vector<std::int32_t> out(size);
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(tricky::compress_values(
+            values.data(), indices.data(), size, out.data(), Isa));
+        benchmark::ClobberMemory();
+    }
+    set_processed(aState);
+}
+
+void sizes(benchmark::internal::Benchmark *aBenchmark)
+{
+    aBenchmark->ArgName("lanes");
+    for (std::int64_t lanes: {1'000, 1'000'000, 100'000'000})
+    {
+        aBenchmark->Arg(lanes);
+    }
+    aBenchmark->Unit(benchmark::kMicrosecond);
+}
+
+// lanes x error rate in per mille
+void sizes_and_errors(benchmark::internal::Benchmark *aBenchmark)
+{
+    aBenchmark->ArgNames({"lanes", "errors_per_mille"});
+    for (std::int64_t lanes: {1'000, 1'000'000, 100'000'000})
+    {
+        for (std::int64_t per_mille: {10, 300})
+        {
+            aBenchmark->Args({lanes, per_mille});
+        }
+    }
+    aBenchmark->Unit(benchmark::kMicrosecond);
+}
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_ContainsError, scan_isa::kScalar)->Apply(sizes);
+BENCHMARK_TEMPLATE(BM_ContainsError, scan_isa::kSSE2)->Apply(sizes);
+BENCHMARK_TEMPLATE(BM_ContainsError, scan_isa::kAVX2)->Apply(sizes);
+
+BENCHMARK_TEMPLATE(BM_FindFirstError, scan_isa::kScalar)->Apply(sizes);
+BENCHMARK_TEMPLATE(BM_FindFirstError, scan_isa::kSSE2)->Apply(sizes);
+BENCHMARK_TEMPLATE(BM_FindFirstError, scan_isa::kAVX2)->Apply(sizes);
+
+BENCHMARK_TEMPLATE(BM_CountIndices, scan_isa::kScalar)->Apply(sizes);
+BENCHMARK_TEMPLATE(BM_CountIndices, scan_isa::kSSE2)->Apply(sizes);
+BENCHMARK_TEMPLATE(BM_CountIndices, scan_isa::kAVX2)->Apply(sizes);
+
+BENCHMARK_TEMPLATE(BM_CompressValues, scan_isa::kScalar)
+    ->Apply(sizes_and_errors);
+BENCHMARK_TEMPLATE(BM_CompressValues, scan_isa::kSSE2)
+    ->Apply(sizes_and_errors);
+BENCHMARK_TEMPLATE(BM_CompressValues, scan_isa::kAVX2)
+    ->Apply(sizes_and_errors);
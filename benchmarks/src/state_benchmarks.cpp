@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+#include <tricky/tricky.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "bench_common.h"
+
+namespace
+{
+using namespace bench_utils;
+
+static_assert(tricky::shared_state::is_thread_local,
+              "state_benchmarks must be built with TRICKY_THREAD_LOCAL_STATE");
+
+int max_threads() noexcept
+{
+    return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+result<int> parse(int aValue, int aErrorEvery) noexcept
+{
+    if (aValue % aErrorEvery == 0)
+    {
+        return {eFileError::kEOF, aValue};
+    }
+    return aValue;
+}
+
+result<int> parse_and_increment(int aValue, int aErrorEvery) noexcept
+{
+    TRICKY_AUTO(value, parse(aValue, aErrorEvery));
+    return value + 1;
+}
+
+// Every thread produces and handles its own results. With a thread local
+// state the throughput is expected to scale linearly with the thread count.
+void BM_ResultRoundTrip(benchmark::State &aState)
+{
+    const auto handle_result = tricky::handlers(
+        tricky::handler([](auto) noexcept { return -1; }));
+    const auto kErrorEvery = static_cast<int>(aState.range(0));
+    int i = 1;
+    for (auto _ : aState)
+    {
+        const int value =
+            handle_result(parse_and_increment(i++, kErrorEvery));
+        benchmark::DoNotOptimize(value);
+    }
+    aState.SetItemsProcessed(aState.iterations());
+}
+}  // namespace
+
+BENCHMARK(BM_ResultRoundTrip)
+    ->ArgName("error_every")
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(1 << 30)
+    ->ThreadRange(1, max_threads())
+    ->UseRealTime();
@@ -0,0 +1,414 @@
+#include <benchmark/benchmark.h>
+#include <tricky/tricky.h>
+
+#include <array>
+#include <cstdio>
+#include <optional>
+#include <variant>
+
+#include "bench_common.h"
+
+namespace
+{
+using namespace bench_utils;
+
+// Every approach reports the same failure: eFileError::kEOF when the input is
+// negative, the input otherwise.
+struct tricky_result
+{
+    using type = result<int>;
+
+    [[gnu::noinline]] static type produce(int aValue) noexcept
+    {
+        if (aValue < 0)
+        {
+            return eFileError::kEOF;
+        }
+        return aValue;
+    }
+
+    [[gnu::noinline]] static type frame(int aValue, int aDepth) noexcept
+    {
+        if (!aDepth)
+        {
+            return produce(aValue);
+        }
+        TRICKY_AUTO(value, frame(aValue, aDepth - 1));
+        return value + 1;
+    }
+
+    static int unwrap(type &&aResult) noexcept
+    {
+        static constexpr auto kHandlers =
+            tricky::handlers(tricky::handler([](auto) noexcept { return -1; }));
+        return kHandlers(std::move(aResult));
+    }
+};
+
+struct optional_result
+{
+    using type = std::optional<int>;
+
+    [[gnu::noinline]] static type produce(int aValue) noexcept
+    {
+        if (aValue < 0)
+        {
+            return std::nullopt;
+        }
+        return aValue;
+    }
+
+    [[gnu::noinline]] static type frame(int aValue, int aDepth) noexcept
+    {
+        if (!aDepth)
+        {
+            return produce(aValue);
+        }
+        const auto value = frame(aValue, aDepth - 1);
+        if (!value)
+        {
+            return value;
+        }
+        return *value + 1;
+    }
+
+    static int unwrap(type &&aResult) noexcept { return aResult.value_or(-1); }
+};
+
+struct variant_result
+{
+    using type = std::variant<int, eFileError>;
+
+    [[gnu::noinline]] static type produce(int aValue) noexcept
+    {
+        if (aValue < 0)
+        {
+            return eFileError::kEOF;
+        }
+        return aValue;
+    }
+
+    [[gnu::noinline]] static type frame(int aValue, int aDepth) noexcept
+    {
+        if (!aDepth)
+        {
+            return produce(aValue);
+        }
+        const auto value = frame(aValue, aDepth - 1);
+        if (const int *ptr = std::get_if<int>(&value))
+        {
+            return *ptr + 1;
+        }
+        return value;
+    }
+
+    static int unwrap(type &&aResult) noexcept
+    {
+        const int *ptr = std::get_if<int>(&aResult);
+        return ptr ? *ptr : -1;
+    }
+};
+
+struct error_code_result
+{
+    // error code and value returned through an out parameter
+    struct type
+    {
+        eFileError code;
+        bool failed;
+        int value;
+    };
+
+    [[gnu::noinline]] static bool produce(int aValue, int &aOut,
+                                          eFileError &aError) noexcept
+    {
+        if (aValue < 0)
+        {
+            aError = eFileError::kEOF;
+            return false;
+        }
+        aOut = aValue;
+        return true;
+    }
+
+    [[gnu::noinline]] static bool frame(int aValue, int aDepth, int &aOut,
+                                        eFileError &aError) noexcept
+    {
+        if (!aDepth)
+        {
+            return produce(aValue, aOut, aError);
+        }
+        int value{};
+        if (!frame(aValue, aDepth - 1, value, aError))
+        {
+            return false;
+        }
+        aOut = value + 1;
+        return true;
+    }
+
+    static type produce(int aValue) noexcept
+    {
+        type r{};
+        r.failed = !produce(aValue, r.value, r.code);
+        return r;
+    }
+
+    static type frame(int aValue, int aDepth) noexcept
+    {
+        type r{};
+        r.failed = !frame(aValue, aDepth, r.value, r.code);
+        return r;
+    }
+
+    static int unwrap(type &&aResult) noexcept
+    {
+        return aResult.failed ? -1 : aResult.value;
+    }
+};
+
+struct exception_result
+{
+    struct error
+    {
+        eFileError code;
+    };
+
+    using type = int;
+
+    [[gnu::noinline]] static int produce_or_throw(int aValue)
+    {
+        if (aValue < 0)
+        {
+            throw error{eFileError::kEOF};
+        }
+        return aValue;
+    }
+
+    [[gnu::noinline]] static int frame_or_throw(int aValue, int aDepth)
+    {
+        if (!aDepth)
+        {
+            return produce_or_throw(aValue);
+        }
+        return frame_or_throw(aValue, aDepth - 1) + 1;
+    }
+
+    static int produce(int aValue) noexcept
+    {
+        try
+        {
+            return produce_or_throw(aValue);
+        }
+        catch (const error &)
+        {
+            return -1;
+        }
+    }
+
+    static int frame(int aValue, int aDepth) noexcept
+    {
+        try
+        {
+            return frame_or_throw(aValue, aDepth);
+        }
+        catch (const error &)
+        {
+            return -1;
+        }
+    }
+
+    static int unwrap(int aValue) noexcept { return aValue; }
+};
+
+// Arg(0) measures the success path, Arg(1) the failure path.
+template <typename Approach>
+void BM_ReturnAndUnwrap(benchmark::State &aState)
+{
+    int input = aState.range(0) ? -1 : 1;
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(input);
+        int value = Approach::unwrap(Approach::produce(input));
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+// Propagates the result through aState.range(1) frames.
+template <typename Approach>
+void BM_Propagate(benchmark::State &aState)
+{
+    int input = aState.range(0) ? -1 : 1;
+    const auto kDepth = static_cast<int>(aState.range(1));
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(input);
+        int value = Approach::unwrap(Approach::frame(input, kDepth));
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+[[gnu::noinline]] result<int> parse(int aValue) noexcept
+{
+    switch (aValue)
+    {
+        case 0:
+            return eReaderError::kError2;
+        case 1:
+            return eWriterError::kError4;
+        case 2:
+            return eFileError::kEOF;
+        default:
+            return aValue;
+    }
+}
+
+// Arg selects the error: 0 is handled by a value handler, 1 by a category
+// handler, 2 by the any handler and 3 is a value.
+void BM_TryHandleAll(benchmark::State &aState)
+{
+    int input = static_cast<int>(aState.range(0));
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(input);
+        const int value = tricky::try_handle_all(
+            [input]() noexcept { return parse(input); },
+            tricky::handlers(
+                tricky::handler<eReaderError::kError2>(
+                    []() noexcept { return -1; }),
+                tricky::handler<eWriterError>([](auto) noexcept
+                                              { return -2; }),
+                tricky::handler([](auto) noexcept { return -3; })));
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+void BM_TryHandleSome(benchmark::State &aState)
+{
+    int input = static_cast<int>(aState.range(0));
+    const auto handle_rest =
+        tricky::handlers(tricky::handler([](auto) noexcept { return -3; }));
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(input);
+        auto r = tricky::try_handle_some(
+            [input]() noexcept { return parse(input); },
+            tricky::handlers(
+                tricky::handler<eReaderError::kError2>(
+                    []() noexcept -> result<int> { return -1; }),
+                tricky::handler<eWriterError>(
+                    [](auto) noexcept -> result<int> { return -2; })));
+        const int value = handle_rest(std::move(r));
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+void BM_LoadPayload(benchmark::State &aState)
+{
+    const auto handle_any =
+        tricky::handlers(tricky::handler([](auto) noexcept { return -1; }));
+    int input = -1;
+    const double kPayload = 2.5;
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(input);
+        auto r = tricky_result::produce(input);
+        r.load(input, kPayload);
+        const int value = handle_any(std::move(r));
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+[[gnu::noinline]] result<int> produce_with_lazy_payload(int aValue) noexcept
+{
+    const auto payload = tricky::on_error(aValue, 2.5);
+    return tricky_result::produce(aValue);
+}
+
+// Arg(0): the lazy_load is destroyed on the success path and loads nothing,
+// Arg(1): it loads its payload on the failure path.
+void BM_LazyLoadDestruction(benchmark::State &aState)
+{
+    int input = aState.range(0) ? -1 : 1;
+    for (auto _ : aState)
+    {
+        benchmark::DoNotOptimize(input);
+        const int value =
+            tricky_result::unwrap(produce_with_lazy_payload(input));
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+// Payload which is costly to build: formatted text about the request.
+struct request_snapshot
+{
+    std::array<char, 96> text;
+};
+
+[[gnu::noinline]] request_snapshot snapshot(int aValue) noexcept
+{
+    request_snapshot s{};
+    std::snprintf(s.text.data(), s.text.size(),
+                  "request %d: GET /items/%d?page=%d", aValue, aValue * 7,
+                  aValue % 13);
+    return s;
+}
+
+[[gnu::noinline]] result<int> produce_with_eager_payload(int aValue) noexcept
+{
+    const auto payload = tricky::on_error(snapshot(aValue));
+    return tricky_result::produce(aValue);
+}
+
+[[gnu::noinline]] result<int> produce_with_deferred_payload(
+    int aValue) noexcept
+{
+    const auto payload = tricky::on_error(
+        tricky::defer([aValue]() noexcept { return snapshot(aValue); }));
+    return tricky_result::produce(aValue);
+}
+
+// One failure per range(0) calls: the eager lazy_load formats its snapshot on
+// every call, the deferred one on failures only.
+template <bool Deferred>
+void BM_CapturePayload(benchmark::State &aState)
+{
+    const auto period = static_cast<int>(aState.range(0));
+    int call = 0;
+    for (auto _ : aState)
+    {
+        const int input = ++call % period ? call : -call;
+        benchmark::DoNotOptimize(input);
+        auto r = Deferred ? produce_with_deferred_payload(input)
+                          : produce_with_eager_payload(input);
+        const int value = tricky_result::unwrap(std::move(r));
+        benchmark::DoNotOptimize(value);
+    }
+}
+}  // namespace
+
+#define TRICKY_BENCH_APPROACHES(bench, ...)                    \
+    BENCHMARK_TEMPLATE(bench, tricky_result)->__VA_ARGS__;     \
+    BENCHMARK_TEMPLATE(bench, optional_result)->__VA_ARGS__;   \
+    BENCHMARK_TEMPLATE(bench, variant_result)->__VA_ARGS__;    \
+    BENCHMARK_TEMPLATE(bench, error_code_result)->__VA_ARGS__; \
+    BENCHMARK_TEMPLATE(bench, exception_result)->__VA_ARGS__
+
+TRICKY_BENCH_APPROACHES(BM_ReturnAndUnwrap,
+                        ArgName("failure")->Arg(0)->Arg(1));
+TRICKY_BENCH_APPROACHES(BM_Propagate,
+                        ArgNames({"failure", "frames"})
+                            ->ArgsProduct({{0, 1}, {1, 4, 16}}));
+
+BENCHMARK(BM_TryHandleAll)->ArgName("handler")->DenseRange(0, 3);
+BENCHMARK(BM_TryHandleSome)->ArgName("handler")->DenseRange(0, 3);
+BENCHMARK(BM_LoadPayload);
+BENCHMARK(BM_LazyLoadDestruction)->ArgName("failure")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_CapturePayload, false)
+    ->ArgName("period")
+    ->Arg(1)
+    ->Arg(1024);
+BENCHMARK_TEMPLATE(BM_CapturePayload, true)
+    ->ArgName("period")
+    ->Arg(1)
+    ->Arg(1024);
@@ -0,0 +1,166 @@
+#ifndef tricky_arena_h
+#define tricky_arena_h
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+namespace tricky
+{
+#ifdef TRICKY_PAYLOAD_ARENA_CHUNK
+inline constexpr std::size_t kPayloadArenaChunk = TRICKY_PAYLOAD_ARENA_CHUNK;
+#else
+inline constexpr std::size_t kPayloadArenaChunk = 4096;
+#endif
+
+// Monotonic arena which takes memory from an upstream resource in chunks of
+// at least chunk_size() bytes. Memory is only given back by release();
+// rewind() makes all chunks available again in O(1).
+class payload_arena
+{
+   public:
+    explicit payload_arena(
+        std::size_t aChunkSize = kPayloadArenaChunk,
+        std::pmr::memory_resource *aUpstream =
+            std::pmr::get_default_resource()) noexcept
+        : chunk_size_(aChunkSize), upstream_(aUpstream)
+    {
+        assert(upstream_ && "upstream resource must not be nullptr.");
+    }
+
+    payload_arena(const payload_arena &) = delete;
+    payload_arena &operator=(const payload_arena &) = delete;
+
+    ~payload_arena() { release(); }
+
+    // Returns nullptr when the upstream resource is exhausted.
+    void *allocate(std::size_t aSize,
+                   std::size_t aAlignment = alignof(std::max_align_t)) noexcept
+    {
+        for (;;)
+        {
+            if (current_)
+            {
+                const auto address = reinterpret_cast<std::uintptr_t>(cursor_);
+                const std::size_t padding =
+                    (aAlignment - address % aAlignment) % aAlignment;
+                if (padding + aSize <= static_cast<std::size_t>(end_ - cursor_))
+                {
+                    void *result = cursor_ + padding;
+                    cursor_ += padding + aSize;
+                    return result;
+                }
+                if (current_->next_)
+                {
+                    enter(current_->next_);
+                    continue;
+                }
+            }
+            if (!grow(aSize + aAlignment))
+            {
+                return nullptr;
+            }
+        }
+    }
+
+    void rewind() noexcept
+    {
+        if (first_)
+        {
+            enter(first_);
+        }
+    }
+
+    void release() noexcept
+    {
+        while (first_)
+        {
+            chunk *next = first_->next_;
+            upstream_->deallocate(first_, first_->size_, alignof(chunk));
+            first_ = next;
+        }
+        last_ = current_ = nullptr;
+        cursor_ = end_ = nullptr;
+    }
+
+    // Releases the chunks and takes memory from aUpstream from now on.
+    void upstream(std::pmr::memory_resource *aUpstream) noexcept
+    {
+        assert(aUpstream && "upstream resource must not be nullptr.");
+        release();
+        upstream_ = aUpstream;
+    }
+
+    std::pmr::memory_resource *upstream() const noexcept { return upstream_; }
+
+    std::size_t chunk_size() const noexcept { return chunk_size_; }
+
+    // bytes taken from the upstream resource
+    std::size_t reserved() const noexcept
+    {
+        std::size_t size = 0;
+        for (chunk *c = first_; c; c = c->next_)
+        {
+            size += c->size_;
+        }
+        return size;
+    }
+
+   private:
+    struct alignas(std::max_align_t) chunk
+    {
+        chunk *next_;
+        std::size_t size_;
+    };
+
+    bool grow(std::size_t aMinSize) noexcept
+    {
+        std::size_t size = sizeof(chunk) + aMinSize;
+        size = size < chunk_size_ ? chunk_size_ : size;
+        void *memory = nullptr;
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+        try
+        {
+            memory = upstream_->allocate(size, alignof(chunk));
+        }
+        catch (const std::bad_alloc &)
+        {
+            return false;
+        }
+#else
+        memory = upstream_->allocate(size, alignof(chunk));
+#endif
+        chunk *c = ::new (memory) chunk{nullptr, size};
+        if (last_)
+        {
+            last_->next_ = c;
+        }
+        else
+        {
+            first_ = c;
+        }
+        last_ = c;
+        enter(c);
+        return true;
+    }
+
+    void enter(chunk *aChunk) noexcept
+    {
+        current_ = aChunk;
+        cursor_ = reinterpret_cast<char *>(aChunk + 1);
+        end_ = reinterpret_cast<char *>(aChunk) + aChunk->size_;
+    }
+
+    std::size_t chunk_size_;
+    std::pmr::memory_resource *upstream_;
+    chunk *first_{nullptr};
+    chunk *last_{nullptr};
+    chunk *current_{nullptr};
+    char *cursor_{nullptr};
+    char *end_{nullptr};
+};
+}  // namespace tricky
+
+#endif /* tricky_arena_h */
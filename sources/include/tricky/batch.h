@@ -0,0 +1,209 @@
+#ifndef tricky_batch_h
+#define tricky_batch_h
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "scan.h"
+#include "tricky.h"
+
+namespace tricky
+{
+// Many results of the same type stored as a struct of arrays: the values of
+// all lanes, the type index of every lane (0 for a value) and a side table
+// with the errors of the failed lanes only. A failed lane keeps a default
+// constructed value.
+template <typename T, typename Error, typename... Errors>
+class result_batch
+{
+    static_assert(!std::is_void_v<T>, "result_batch<void, ...> is useless");
+
+   public:
+    // result<...> a single lane converts to
+    using lane_result = inline_result<T, Error, Errors...>;
+    using value_type = T;
+    using index_t = typename lane_result::index_t;
+
+    result_batch() = default;
+
+    void reserve(std::size_t aSize)
+    {
+        values_.reserve(aSize);
+        indices_.reserve(aSize);
+    }
+
+    void clear() noexcept
+    {
+        values_.clear();
+        indices_.clear();
+        errors_.clear();
+    }
+
+    // push_value() and push_error() leave the batch as it was if they throw
+    template <typename U>
+    void push_value(U &&aValue)
+    {
+        reserve_one(indices_);
+        values_.emplace_back(std::forward<U>(aValue));
+        indices_.push_back(0);
+    }
+
+    template <typename E>
+    void push_error(E aError)
+    {
+        constexpr std::size_t kIndex =
+            error_types::template first_index_of_type<E>;
+        static_assert(kIndex != error_types::size,
+                      "E is not an error type of the batch");
+        reserve_one(errors_);
+        reserve_one(indices_);
+        const std::size_t lane = values_.size();
+        values_.emplace_back();
+        errors_.push_back({lane, error_union{aError}});
+        indices_.push_back(static_cast<index_t>(kIndex + 1));
+    }
+
+    std::size_t size() const noexcept { return values_.size(); }
+    bool empty() const noexcept { return values_.empty(); }
+    std::size_t error_count() const noexcept { return errors_.size(); }
+
+    bool has_error(std::size_t aLane) const noexcept
+    {
+        assert(aLane < size() && "invalid lane");
+        return indices_[aLane];
+    }
+
+    // contiguous arrays of size() elements
+    const T *values() const noexcept { return values_.data(); }
+    const index_t *indices() const noexcept { return indices_.data(); }
+
+    // counts[0] is the number of values, counts[i + 1] the number of lanes
+    // that failed with the i-th error type
+    std::array<std::size_t, lane_result::type_count> error_counts()
+        const noexcept
+    {
+        return count_indices<lane_result::type_count>(indices(), size());
+    }
+
+    // Copies the values of the successful lanes to aOut, which must have
+    // room for size() values, and returns the end of the copied range.
+    T *compress_values(T *aOut) const
+    {
+        return aOut +
+               tricky::compress_values(values(), indices(), size(), aOut);
+    }
+
+    lane_result operator[](std::size_t aLane) const noexcept(
+        std::is_nothrow_copy_constructible_v<T>)
+    {
+        assert(aLane < size() && "invalid lane");
+        if (!indices_[aLane])
+        {
+            return lane_result(std::in_place, values_[aLane]);
+        }
+        const auto it = std::lower_bound(
+            errors_.begin(), errors_.end(), aLane,
+            [](const entry &aEntry, std::size_t aValue) noexcept
+            { return aEntry.lane < aValue; });
+        return make_lane_result(*it);
+    }
+
+    // Writes the value of every lane to aOut. Runs of values are copied in a
+    // tight loop; only the failed lanes go through aHandlers, which must
+    // contain an any-handler returning T.
+    template <typename Handlers, typename OutputIt>
+    OutputIt handle_all(const Handlers &aHandlers, OutputIt aOut) const
+    {
+        static_assert(is_handlers_v<Handlers>);
+        static_assert(std::is_same_v<typename Handlers::return_type, T>,
+                      "handlers must turn every error into T");
+        std::size_t lane = 0;
+        for (const entry &error: errors_)
+        {
+            aOut = std::copy(values_.begin() + lane,
+                             values_.begin() + error.lane, aOut);
+            *aOut = aHandlers(make_lane_result(error));
+            ++aOut;
+            lane = error.lane + 1;
+        }
+        return std::copy(values_.begin() + lane, values_.end(), aOut);
+    }
+
+    // Calls aOnValue(lane, value) for the successful lanes and aHandlers
+    // with the lane_result of every failed one, in lane order.
+    template <typename OnValue, typename Handlers>
+    void for_each(OnValue &&aOnValue, const Handlers &aHandlers) const
+    {
+        static_assert(is_handlers_v<Handlers>);
+        std::size_t lane = 0;
+        for (const entry &error: errors_)
+        {
+            for (; lane != error.lane; ++lane)
+            {
+                aOnValue(lane, values_[lane]);
+            }
+            aHandlers(make_lane_result(error));
+            ++lane;
+        }
+        for (; lane != values_.size(); ++lane)
+        {
+            aOnValue(lane, values_[lane]);
+        }
+    }
+
+   private:
+    using error_types = utils::type_list<Error, Errors...>;
+    using error_union = details::any_error<Error, Errors...>;
+
+    struct entry
+    {
+        std::size_t lane;
+        error_union error;
+    };
+
+    // makes room for one more element, so that its push_back can not throw
+    template <typename V>
+    static void reserve_one(std::vector<V> &aVector)
+    {
+        if (aVector.size() == aVector.capacity())
+        {
+            aVector.reserve(std::max<std::size_t>(2 * aVector.size(), 8));
+        }
+    }
+
+    // Failed lanes were reported when their errors were produced, so they
+    // are rebuilt without telemetry. Lanes are inline results: handling
+    // them leaves shared_state alone.
+    lane_result make_lane_result(const entry &aEntry) const noexcept
+    {
+        return make_lane_result(aEntry, indices_[aEntry.lane] - 1,
+                                std::index_sequence_for<Error, Errors...>{});
+    }
+
+    // unlike any_error::perform() this is inlined into the handling loop
+    template <std::size_t... I>
+    static lane_result make_lane_result(const entry &aEntry, std::size_t aIndex,
+                                        std::index_sequence<I...>) noexcept
+    {
+        lane_result r;
+        static_cast<void>(
+            (... || (aIndex == I &&
+                     (r = lane_result{details::error_tag{},
+                                      aEntry.error.template get<I>()},
+                      true))));
+        return r;
+    }
+
+    std::vector<T> values_;
+    std::vector<index_t> indices_;
+    // sorted by lane
+    std::vector<entry> errors_;
+};
+}  // namespace tricky
+
+#endif /* tricky_batch_h */
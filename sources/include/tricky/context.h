@@ -5,12 +5,15 @@
 #include <utils/utils.h>
 
 #include <algorithm>
+#include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <functional>
 #include <new>
 #include <type_traits>
 
 #include "error.h"
+#include "export.h"
 
 namespace tricky
 {
@@ -38,10 +41,35 @@ struct is_context<heavy_context<Payload, Errors...>> : std::true_type
 template <typename T>
 inline constexpr bool is_context_v = is_context<T>::value;
 
+class polymorphic_context;
+
 namespace details
 {
 namespace ctx
 {
+enum : std::uint8_t
+{
+    kIsActive = 0b00000001,
+    kHasError = 0b00000010
+};
+
+// Operations of polymorphic_context on the error of its concrete context,
+// one table per context type.
+struct polymorphic_ops
+{
+    error_ops::view (*error)(polymorphic_context &aCtx) noexcept;
+    bool (*accept)(polymorphic_context &aCtx, error_ops::view aError) noexcept;
+    void (*release)(polymorphic_context &aCtx) noexcept;
+};
+
+template <typename E>
+inline constexpr std::size_t inline_size =
+    sizeof(E) <= kErrorInlineSize ? sizeof(E) : 0;
+
+template <typename E>
+inline constexpr std::size_t inline_alignment =
+    sizeof(E) <= kErrorInlineSize ? alignof(E) : 1;
+
 template <typename T, typename E>
 void set_error(E aError, T &aCtx) noexcept
 {
@@ -63,25 +91,136 @@ void reset_error(T &aCtx) noexcept
     reinterpret_cast<error_t *>(aCtx.data_)->~error_t();
     aCtx.reset(T::kHasError);
 }
+
+// Takes over aError when aCtx has no error yet and aError is one of its
+// errors, stored the same way as in the error_t of aCtx.
+template <typename T>
+bool accept_error(T &aCtx, error_ops::view aError) noexcept
+{
+    static_assert(is_context_v<T>);
+    using error_t = typename T::error_t;
+    if (aCtx.has_error() || !T::accepts(aError))
+    {
+        return false;
+    }
+
+    new (aCtx.data_) error_t(aError);
+
+    aCtx.set(T::kHasError);
+    return true;
+}
+
+template <typename T>
+std::uint8_t &state(T &aCtx) noexcept
+{
+    static_assert(is_context_v<T>);
+    return aCtx.state_;
+}
 }  // namespace ctx
 }  // namespace details
 
+// Context which can be activated through a base pointer without virtual
+// calls. Active contexts of a thread form an intrusive stack: activate()
+// pushes the context, deactivate() pops it, so nested scopes restore the
+// outer context on exit. An error left in the context when it is
+// deactivated is forwarded to the outer one.
 class polymorphic_context
 {
    public:
-    virtual bool is_active() const noexcept = 0;
-    virtual void activate() noexcept = 0;
-    virtual void deactivate() noexcept = 0;
+    // the context is on the stack of active contexts
+    bool is_active() const noexcept { return active_; }
+
+    bool has_error() const noexcept
+    {
+        return *state_ & details::ctx::kHasError;
+    }
+
+    void activate() noexcept
+    {
+        assert(!active_ && "context is already active");
+        polymorphic_context *&top = active_context();
+        previous_ = top;
+        top = this;
+        active_ = true;
+    }
+
+    void deactivate() noexcept
+    {
+        assert(active_ && "context is not active");
+        polymorphic_context *&top = active_context();
+        assert(top == this && "contexts are deactivated in reverse order");
+        top = previous_;
+        if (previous_ && has_error())
+        {
+            forward(*previous_);
+        }
+        previous_ = nullptr;
+        active_ = false;
+    }
+
+    // Relocates the error of this context into aOuter in O(1). Returns false
+    // and keeps the error when aOuter already has one or can not hold it.
+    bool forward(polymorphic_context &aOuter) noexcept
+    {
+        assert(has_error());
+        if (!aOuter.ops_->accept(aOuter, ops_->error(*this)))
+        {
+            return false;
+        }
+        ops_->release(*this);
+        return true;
+    }
+
+    // innermost active context of the calling thread or nullptr
+    static polymorphic_context *current() noexcept { return active_context(); }
+
+    // context which was active when this one was activated
+    polymorphic_context *previous() const noexcept { return previous_; }
 
    protected:
-    polymorphic_context() noexcept = default;
-    virtual ~polymorphic_context() noexcept = default;
+    explicit polymorphic_context(
+        const details::ctx::polymorphic_ops &aOps) noexcept
+        : ops_(&aOps)
+    {
+    }
 
-    thread_local static polymorphic_context *active_context_;
-};
+    ~polymorphic_context() noexcept
+    {
+        assert(!active_ && "active context is destroyed");
+    }
+
+    polymorphic_context(const polymorphic_context &) = delete;
 
-thread_local polymorphic_context *polymorphic_context::active_context_ =
-    nullptr;
+    // an active context is linked into the stack and must not move
+    polymorphic_context &operator=(const polymorphic_context &aOther) noexcept
+    {
+        assert(!active_ && !aOther.active_ && "active context is moved");
+        static_cast<void>(aOther);
+        return *this;
+    }
+
+    // state of the concrete context, bound once it is constructed
+    void bind(std::uint8_t &aState) noexcept { state_ = &aState; }
+
+#ifdef TRICKY_STATE_DSO
+    // defined in the library built by tricky_add_state_library()
+    TRICKY_STATE_API static polymorphic_context *&active_context() noexcept;
+#else
+    static polymorphic_context *&active_context() noexcept
+    {
+        return active_context_;
+    }
+#endif
+
+   private:
+#ifndef TRICKY_STATE_DSO
+    thread_local static inline polymorphic_context *active_context_{nullptr};
+#endif
+    const details::ctx::polymorphic_ops *ops_;
+    std::uint8_t *state_{nullptr};
+    polymorphic_context *previous_{nullptr};
+    bool active_{false};
+};
 
 template <typename Error, typename... RestErrors>
 class context
@@ -92,18 +231,40 @@ class context
     template <typename T>
     friend void details::ctx::reset_error(T &aCtx) noexcept;
 
+    template <typename T>
+    friend bool details::ctx::accept_error(
+        T &aCtx, details::error_ops::view aError) noexcept;
+
+    template <typename T>
+    friend std::uint8_t &details::ctx::state(T &aCtx) noexcept;
+
    public:
     using error_type_list = utils::type_list<Error, RestErrors...>;
-    using error_t = error<std::max({sizeof(Error), sizeof(RestErrors)...}),
-                          std::max({alignof(Error), alignof(RestErrors)...})>;
+    // inline room for the errors of up to kErrorInlineSize bytes only, so
+    // that one large error type does not grow every context
+    using error_t = tricky::error<
+        std::max({details::ctx::inline_size<Error>,
+                  details::ctx::inline_size<RestErrors>...}),
+        std::max({details::ctx::inline_alignment<Error>,
+                  details::ctx::inline_alignment<RestErrors>...})>;
 
    private:
     enum : std::uint8_t
     {
-        kIsActive = 0b00000001,
-        kHasError = 0b00000010
+        kIsActive = details::ctx::kIsActive,
+        kHasError = details::ctx::kHasError
     };
 
+    static bool accepts(details::error_ops::view aError) noexcept
+    {
+        return error_t::template accepts<Error, RestErrors...>(aError);
+    }
+
+    // every error of the context moves with a memcpy of its error_t
+    static constexpr bool kTriviallyRelocatable =
+        (error_t::template is_trivially_relocatable<Error> && ... &&
+         error_t::template is_trivially_relocatable<RestErrors>);
+
     void move_error_helper(context &aCtx) noexcept
     {
         if (has_error())
@@ -111,7 +272,17 @@ class context
             details::ctx::reset_error(*this);
         }
 
-        if (aCtx.has_error())
+        if constexpr (kTriviallyRelocatable)
+        {
+            // the bytes are copied whether or not there is an error: a
+            // fixed-size copy is cheaper than a branch and the object, if
+            // any, now lives here
+            std::memcpy(data_, aCtx.data_, sizeof(data_));
+            state_ = static_cast<std::uint8_t>(state_ |
+                                               (aCtx.state_ & kHasError));
+            aCtx.reset(kHasError);
+        }
+        else if (aCtx.has_error())
         {
             new (data_) error_t(std::move(aCtx.error()));
             this->set(kHasError);
@@ -161,7 +332,7 @@ class context
         const noexcept
     {
         assert(has_error<E>());
-        return *reinterpret_cast<E const *>(data_);
+        return error().template value<E>();
     }
 
     inline bool is_active() const noexcept { return check(kIsActive); }
@@ -246,22 +417,67 @@ struct polymorphic_context_impl
     : polymorphic_context
     , Context
 {
-    bool is_active() const noexcept override final
+    polymorphic_context_impl() noexcept : polymorphic_context(kOps), Context()
+    {
+        bind(ctx::state<Context>(*this));
+    }
+
+    template <typename Arg, typename... Args,
+              typename = std::enable_if_t<!std::is_base_of_v<
+                  polymorphic_context, utils::remove_cvref_t<Arg>>>>
+    explicit polymorphic_context_impl(Arg &&aArg, Args &&...aArgs) noexcept
+        : polymorphic_context(kOps),
+          Context(std::forward<Arg>(aArg), std::forward<Args>(aArgs)...)
     {
-        return this == active_context_;
+        bind(ctx::state<Context>(*this));
     }
 
-    void activate() noexcept override final
+    polymorphic_context_impl(polymorphic_context_impl &&aOther) noexcept
+        : polymorphic_context(kOps), Context(std::move(aOther))
     {
-        Context::activate();
-        active_context_ = this;
+        assert(!aOther.is_active() && "active context is moved");
+        bind(ctx::state<Context>(*this));
     }
 
-    void deactivate() noexcept override final
+    polymorphic_context_impl &operator=(
+        polymorphic_context_impl &&aOther) noexcept
     {
-        active_context_ = nullptr;
-        Context::deactivate();
+        polymorphic_context::operator=(aOther);
+        Context::operator=(std::move(aOther));
+        return *this;
     }
+
+    // the stack of polymorphic_context decides whether the context is active
+    using polymorphic_context::activate;
+    using polymorphic_context::deactivate;
+    using polymorphic_context::is_active;
+
+    using Context::has_error;
+
+   private:
+    static polymorphic_context_impl &self(polymorphic_context &aCtx) noexcept
+    {
+        return static_cast<polymorphic_context_impl &>(aCtx);
+    }
+
+    static error_ops::view pending_error(polymorphic_context &aCtx) noexcept
+    {
+        return self(aCtx).error().view();
+    }
+
+    static bool accept(polymorphic_context &aCtx,
+                       error_ops::view aError) noexcept
+    {
+        return ctx::accept_error<Context>(self(aCtx), aError);
+    }
+
+    static void release(polymorphic_context &aCtx) noexcept
+    {
+        ctx::reset_error<Context>(self(aCtx));
+    }
+
+    static constexpr ctx::polymorphic_ops kOps{&pending_error, &accept,
+                                                &release};
 };
 }  // namespace details
 
@@ -0,0 +1,298 @@
+#ifndef tricky_context_pool_h
+#define tricky_context_pool_h
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "context.h"
+
+namespace tricky
+{
+#ifdef TRICKY_CONTEXT_POOL_PAYLOAD_SIZE
+inline constexpr std::size_t kContextPoolPayloadSize =
+    TRICKY_CONTEXT_POOL_PAYLOAD_SIZE;
+#else
+inline constexpr std::size_t kContextPoolPayloadSize = 256;
+#endif
+
+template <typename Context, std::size_t PayloadSize>
+class context_pool;
+
+namespace details
+{
+namespace pool
+{
+template <typename Context, std::size_t PayloadSize>
+class cache;
+
+// A heavy context constructed once together with its payload buffer. The
+// node belongs to the cache of the thread which allocated it.
+template <typename Context, std::size_t PayloadSize>
+struct node
+{
+    using cache_t = cache<Context, PayloadSize>;
+
+    explicit node(cache_t *aOwner) noexcept
+        : context(buffer, PayloadSize), owner(aOwner)
+    {
+    }
+
+    alignas(std::max_align_t) char buffer[PayloadSize];
+    Context context;
+    cache_t *const owner;
+    node *next{nullptr};
+};
+
+// Free list of one thread. Only the owning thread touches free_; other
+// threads push the nodes they release onto returned_ (Treiber stack) and the
+// owner takes the whole stack at once, so pops never race and there is no
+// ABA problem.
+template <typename Context, std::size_t PayloadSize>
+class cache
+{
+   public:
+    using node_t = node<Context, PayloadSize>;
+
+    node_t *pop() noexcept
+    {
+        if (!free_)
+        {
+            free_ = returned_.exchange(nullptr, std::memory_order_acquire);
+        }
+        node_t *n = free_;
+        if (n)
+        {
+            free_ = n->next;
+        }
+        return n;
+    }
+
+    void push_local(node_t *aNode) noexcept
+    {
+        aNode->next = free_;
+        free_ = aNode;
+    }
+
+    void push_remote(node_t *aNode) noexcept
+    {
+        aNode->next = returned_.load(std::memory_order_relaxed);
+        while (!returned_.compare_exchange_weak(aNode->next, aNode,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed))
+        {
+        }
+    }
+
+    bool try_own() noexcept
+    {
+        return !owned_.exchange(true, std::memory_order_acquire);
+    }
+
+    void disown() noexcept { owned_.store(false, std::memory_order_release); }
+
+    cache *next_{nullptr};
+
+   private:
+    node_t *free_{nullptr};
+    // on its own cache line: written by the releasing threads
+    alignas(64) std::atomic<node_t *> returned_{nullptr};
+    std::atomic<bool> owned_{};
+};
+}  // namespace pool
+}  // namespace details
+
+// Hands out heavy contexts which are constructed once, together with a
+// payload buffer of PayloadSize bytes, and recycled afterwards. Every thread
+// takes contexts from its own free list; a context released on another
+// thread goes back to the list of its owner without locks. Nodes and caches
+// are never freed: the cache of an exited thread, with its contexts, is
+// reused by the next new thread.
+template <typename Context, std::size_t PayloadSize = kContextPoolPayloadSize>
+class context_pool
+{
+    static_assert(is_context_v<Context>);
+
+    using cache_t = details::pool::cache<Context, PayloadSize>;
+    using node_t = details::pool::node<Context, PayloadSize>;
+
+   public:
+    using context_t = Context;
+
+    static constexpr std::size_t payload_size = PayloadSize;
+
+    // Owns a pooled context and gives it back to the pool on scope exit.
+    // The context must not be moved out of the handle.
+    class handle
+    {
+       public:
+        handle() noexcept = default;
+        handle(const handle &) = delete;
+        handle &operator=(const handle &) = delete;
+
+        handle(handle &&aOther) noexcept
+            : node_(std::exchange(aOther.node_, nullptr))
+        {
+        }
+
+        handle &operator=(handle &&aOther) noexcept
+        {
+            if (this != &aOther)
+            {
+                reset();
+                node_ = std::exchange(aOther.node_, nullptr);
+            }
+            return *this;
+        }
+
+        ~handle() { reset(); }
+
+        explicit operator bool() const noexcept { return node_ != nullptr; }
+
+        Context &operator*() const noexcept
+        {
+            assert(node_ && "empty handle");
+            return node_->context;
+        }
+
+        Context *operator->() const noexcept
+        {
+            assert(node_ && "empty handle");
+            return &node_->context;
+        }
+
+        void reset() noexcept
+        {
+            if (node_)
+            {
+                context_pool::release(std::exchange(node_, nullptr));
+            }
+        }
+
+       private:
+        friend class context_pool;
+
+        explicit handle(node_t *aNode) noexcept : node_(aNode) {}
+
+        node_t *node_{nullptr};
+    };
+
+    // Returns an empty handle when a new context can not be allocated or the
+    // calling thread is exiting and its free list is already gone.
+    static handle acquire() noexcept
+    {
+        cache_t *c = local();
+        if (!c)
+        {
+            return handle{};
+        }
+        node_t *n = c->pop();
+        if (!n)
+        {
+            n = new (std::nothrow) node_t(c);
+            if (n)
+            {
+                allocated_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return handle{n};
+    }
+
+    // number of contexts allocated by the pool so far
+    static std::size_t allocated() noexcept
+    {
+        return allocated_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    // cheap reset: the context and its buffer stay constructed, only the
+    // payload is dropped
+    static void release(node_t *aNode) noexcept
+    {
+        Context &ctx = aNode->context;
+        assert(!ctx.has_error() && "error of a pooled context is not handled");
+        assert(!ctx.is_active() && "pooled context is still active");
+        assert(ctx.payload().data() &&
+               "pooled context was moved out of its handle");
+        ctx.payload().reset();
+
+        // the owner object may already be destroyed when a handle is released
+        // by a later thread_local destructor: local_ is null then
+        if (local_ == aNode->owner)
+        {
+            local_->push_local(aNode);
+        }
+        else
+        {
+            aNode->owner->push_remote(aNode);
+        }
+    }
+
+    class owner
+    {
+       public:
+        owner() noexcept : cache_(acquire_cache()) { local_ = cache_; }
+        ~owner()
+        {
+            local_ = nullptr;
+            exited_ = true;
+            if (cache_)
+            {
+                cache_->disown();
+            }
+        }
+        owner(const owner &) = delete;
+        owner &operator=(const owner &) = delete;
+
+       private:
+        cache_t *cache_;
+    };
+
+    static cache_t *local() noexcept
+    {
+        if (!local_ && !exited_)
+        {
+            thread_local owner o;
+        }
+        return local_;
+    }
+
+    static cache_t *acquire_cache() noexcept
+    {
+        cache_t *head = caches_.load(std::memory_order_acquire);
+        for (cache_t *c = head; c; c = c->next_)
+        {
+            if (c->try_own())
+            {
+                return c;
+            }
+        }
+        cache_t *c = new (std::nothrow) cache_t;
+        if (!c)
+        {
+            return nullptr;
+        }
+        c->try_own();
+        c->next_ = head;
+        while (!caches_.compare_exchange_weak(c->next_, c,
+                                              std::memory_order_release,
+                                              std::memory_order_acquire))
+        {
+        }
+        return c;
+    }
+
+    // Trivially destructible, so they stay readable during the whole thread
+    // exit, unlike the owner which disowns the cache of the thread.
+    static inline thread_local cache_t *local_{nullptr};
+    static inline thread_local bool exited_{};
+
+    static inline std::atomic<cache_t *> caches_{nullptr};
+    static inline std::atomic<std::size_t> allocated_{};
+};
+}  // namespace tricky
+
+#endif /* tricky_context_pool_h */
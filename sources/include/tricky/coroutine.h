@@ -0,0 +1,320 @@
+#ifndef tricky_coroutine_h
+#define tricky_coroutine_h
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "tricky.h"
+
+#ifndef TRICKY_COROUTINES
+#error "tricky/coroutine.h requires TRICKY_COROUTINES to be defined"
+#endif
+
+// Same as TRICKY_ASSIGN but for coroutines returning tricky::task<...>.
+// r may be a co_await expression.
+#define TRICKY_CO_ASSIGN(v, r)                                                \
+    auto &&TRICKY_TMP = r;                                                    \
+    static_assert(tricky::is_result_v<std::decay_t<decltype(TRICKY_TMP)>>,    \
+                  "second argument must be tricky::result<>. See is_result"); \
+    if (!TRICKY_TMP) co_return std::forward<decltype(TRICKY_TMP)>(TRICKY_TMP);\
+    v = std::forward<decltype(TRICKY_TMP)>(TRICKY_TMP).value()
+
+#define TRICKY_CO_AUTO(v, r) TRICKY_CO_ASSIGN(auto v, r)
+
+namespace tricky
+{
+template <typename Result>
+class task;
+
+template <typename Result>
+Result sync_wait(task<Result> aTask) noexcept;
+
+namespace details
+{
+// Error state of a chain of coroutines. The state travels with the frame:
+// it is activated on the thread which resumes the coroutine and the state
+// of that thread is restored before the coroutine suspends.
+class frame_state
+{
+   public:
+    void enter() noexcept { resumer_ = shared_state::activate(state_); }
+    void leave() noexcept { shared_state::activate(resumer_); }
+
+    state *get() const noexcept { return state_; }
+    void set(state *aState) noexcept { state_ = aState; }
+
+   private:
+    state *state_{nullptr};
+    state *resumer_{nullptr};
+};
+
+template <typename Awaitable>
+class state_awaiter
+{
+   public:
+    state_awaiter(Awaitable &&aAwaitable, frame_state &aState) noexcept
+        : awaitable_(std::forward<Awaitable>(aAwaitable)), state_(aState)
+    {
+    }
+
+    bool await_ready() noexcept(noexcept(awaitable_.await_ready()))
+    {
+        return awaitable_.await_ready();
+    }
+
+    template <typename Promise>
+    decltype(auto) await_suspend(std::coroutine_handle<Promise> aHandle)
+    {
+        // the coroutine can be resumed on another thread as soon as the
+        // inner await_suspend is called, so nothing is touched after it
+        suspended_ = true;
+        state_.leave();
+        return awaitable_.await_suspend(aHandle);
+    }
+
+    decltype(auto) await_resume()
+    {
+        if (suspended_)
+        {
+            state_.enter();
+        }
+        return awaitable_.await_resume();
+    }
+
+   private:
+    Awaitable awaitable_;
+    frame_state &state_;
+    bool suspended_{};
+};
+
+template <typename Result>
+class task_promise
+{
+   public:
+    using handle = std::coroutine_handle<task_promise>;
+
+    task<Result> get_return_object() noexcept;
+
+    auto initial_suspend() noexcept
+    {
+        struct awaiter
+        {
+            frame_state &state_;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<>) const noexcept {}
+            void await_resume() const noexcept { state_.enter(); }
+        };
+        return awaiter{state_};
+    }
+
+    auto final_suspend() noexcept
+    {
+        struct awaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(handle aHandle) noexcept
+            {
+                task_promise &promise = aHandle.promise();
+                promise.state_.leave();
+                return promise.continuation_;
+            }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{};
+    }
+
+    template <typename U,
+              typename = std::enable_if_t<std::is_constructible_v<Result, U>>>
+    void return_value(U &&aValue) noexcept(
+        std::is_nothrow_constructible_v<Result, U>)
+    {
+        result_.emplace(std::forward<U>(aValue));
+    }
+
+    void unhandled_exception() noexcept { std::terminate(); }
+
+    template <typename R>
+    auto await_transform(task<R> &&aTask) noexcept
+    {
+        aTask.handle_.promise().state_.set(state_.get());
+        return await_transform(std::move(aTask).operator co_await());
+    }
+
+    template <typename Awaitable>
+    auto await_transform(Awaitable &&aAwaitable) noexcept
+    {
+        return state_awaiter<Awaitable>(std::forward<Awaitable>(aAwaitable),
+                                        state_);
+    }
+
+   private:
+    template <typename R>
+    friend class tricky::task;
+    template <typename R>
+    friend class task_promise;
+    template <typename R>
+    friend R tricky::sync_wait(task<R> aTask) noexcept;
+
+    frame_state state_;
+    std::coroutine_handle<> continuation_{std::noop_coroutine()};
+    std::optional<Result> result_;
+};
+}  // namespace details
+
+// Lazily started coroutine producing Result (a tricky::result<...>). A task
+// runs when it is co_await-ed by another task, which shares its error state
+// with it, or by sync_wait(), which lends it the state of the calling
+// thread. Results with errors therefore stay valid while the coroutine
+// moves between threads.
+template <typename Result>
+class task
+{
+    static_assert(is_result_v<Result>, "Result must be tricky::result<>.");
+
+   public:
+    using promise_type = details::task_promise<Result>;
+    using result_type = Result;
+
+    task(task &&aOther) noexcept : handle_(std::exchange(aOther.handle_, {}))
+    {
+    }
+
+    task &operator=(task &&aOther) noexcept
+    {
+        if (this != &aOther)
+        {
+            destroy();
+            handle_ = std::exchange(aOther.handle_, {});
+        }
+        return *this;
+    }
+
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+
+    ~task() { destroy(); }
+
+    auto operator co_await() && noexcept
+    {
+        struct awaiter : completion
+        {
+            Result await_resume() noexcept
+            {
+                return std::move(*this->handle_.promise().result_);
+            }
+        };
+        return awaiter{{handle_}};
+    }
+
+   private:
+    // Runs the task and resumes the awaiting coroutine when it finishes,
+    // leaving the result in the promise.
+    struct completion
+    {
+        typename promise_type::handle handle_;
+
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(
+            std::coroutine_handle<> aContinuation) noexcept
+        {
+            handle_.promise().continuation_ = aContinuation;
+            return handle_;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    friend promise_type;
+    template <typename R>
+    friend class details::task_promise;
+    template <typename R>
+    friend R sync_wait(task<R> aTask) noexcept;
+
+    explicit task(typename promise_type::handle aHandle) noexcept
+        : handle_(aHandle)
+    {
+    }
+
+    void destroy() noexcept
+    {
+        if (handle_)
+        {
+            handle_.destroy();
+        }
+    }
+
+    typename promise_type::handle handle_;
+};
+
+template <typename Result>
+task<Result> details::task_promise<Result>::get_return_object() noexcept
+{
+    return task<Result>(handle::from_promise(*this));
+}
+
+namespace details
+{
+struct sync_waiter
+{
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    bool done_{};
+};
+
+// Coroutine which resumes the thread blocked in sync_wait().
+struct sync_notifier
+{
+    struct promise_type
+    {
+        template <typename Completion>
+        promise_type(Completion &, sync_waiter &aWaiter) noexcept
+            : waiter_(aWaiter)
+        {
+        }
+
+        sync_notifier get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept
+        {
+            std::lock_guard lock(waiter_.mutex_);
+            waiter_.done_ = true;
+            waiter_.finished_.notify_one();
+        }
+        void unhandled_exception() noexcept { std::terminate(); }
+
+        sync_waiter &waiter_;
+    };
+};
+
+// Awaits aCompletion, which does not take the result: sync_wait() moves it
+// out of the promise once.
+template <typename Completion>
+sync_notifier run_and_notify(Completion aCompletion, sync_waiter &)
+{
+    co_await aCompletion;
+}
+}  // namespace details
+
+// Runs aTask to completion and blocks until it finishes, possibly on other
+// threads. Errors are reported through the state of the calling thread.
+template <typename Result>
+Result sync_wait(task<Result> aTask) noexcept
+{
+    auto &promise = aTask.handle_.promise();
+    promise.state_.set(shared_state::active());
+    details::sync_waiter waiter;
+    details::run_and_notify(
+        typename task<Result>::completion{aTask.handle_}, waiter);
+    std::unique_lock lock(waiter.mutex_);
+    waiter.finished_.wait(lock, [&waiter]() noexcept { return waiter.done_; });
+    return std::move(*promise.result_);
+}
+}  // namespace tricky
+
+#endif /* tricky_coroutine_h */
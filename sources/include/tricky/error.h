@@ -5,13 +5,50 @@
 #include <type_name/type_name.h>
 #include <utils/utils.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <functional>
+#include <cstring>
+#include <memory_resource>
 #include <new>
+#include <system_error>
 #include <type_traits>
 
 namespace tricky
 {
+#ifdef TRICKY_ERROR_INLINE_SIZE
+inline constexpr std::size_t kErrorInlineSize = TRICKY_ERROR_INLINE_SIZE;
+#else
+inline constexpr std::size_t kErrorInlineSize = 2 * sizeof(void *);
+#endif
+
+// Memory of the errors which do not fit into the inline buffer of their
+// tricky::error. A synchronized pool by default, resource() switches to
+// another one. Every spilled error goes back to the resource it came from.
+class error_spill
+{
+   public:
+    static std::pmr::memory_resource *resource() noexcept
+    {
+        auto *resource = resource_.load(std::memory_order_acquire);
+        return resource ? resource : default_resource();
+    }
+
+    static void resource(std::pmr::memory_resource *aResource) noexcept
+    {
+        resource_.store(aResource, std::memory_order_release);
+    }
+
+   private:
+    static std::pmr::memory_resource *default_resource() noexcept
+    {
+        static std::pmr::synchronized_pool_resource pool;
+        return &pool;
+    }
+
+    static inline std::atomic<std::pmr::memory_resource *> resource_{nullptr};
+};
+
 namespace details
 {
 namespace error_ops
@@ -25,47 +62,129 @@ struct DataPtrOps
 {
 };
 
-using Src = strong::strong_type<struct SrcTag, std::byte const *, DataPtrOps>;
 using Dst = strong::strong_type<struct DstTag, std::byte *, DataPtrOps>;
 
-template <typename T>
-using error_destroyer_t = void (*)(T &) noexcept;
-using error_copier_t = void (*)(Dst aDst, Src aSrc) noexcept;
+// Operations on an error of one type, shared by every tricky::error holding
+// an error of that type. Its address identifies the type.
+struct vtable
+{
+    // nullptr when the error is inline and trivially destructible
+    void (*destroy)(Dst aData) noexcept;
+    // nullptr when moving the error is a memcpy of the inline buffer: the
+    // error is trivially copyable or spilled (the buffer holds a pointer)
+    void (*relocate)(Dst aDst, Dst aSrc) noexcept;
+    const std::string_view *type_name;
+};
+
+// Inline buffer and vtable slot of a tricky::error of any size.
+struct view
+{
+    std::byte *data;
+    std::size_t size;
+    const vtable **slot;
+};
+
+// An error which did not fit into the inline buffer, together with the
+// resource it was allocated from.
+template <typename E>
+struct spilled_error
+{
+    std::pmr::memory_resource *resource;
+    E value;
+};
+
+// nullptr when aResource is exhausted
+inline void *allocate_spilled(std::pmr::memory_resource *aResource,
+                              std::size_t aSize,
+                              std::size_t aAlignment) noexcept
+{
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+    try
+    {
+        return aResource->allocate(aSize, aAlignment);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return nullptr;
+    }
+#else
+    return aResource->allocate(aSize, aAlignment);
+#endif
+}
+
+template <typename E>
+void destroy_error(Dst aData) noexcept
+{
+    std::launder(reinterpret_cast<E *>(aData.get()))->~E();
+}
 
-template <typename E, typename T>
-void destroy_error(T &aErrorObject) noexcept
+template <typename E>
+void destroy_spilled_error(Dst aData) noexcept
 {
-    aErrorObject.template reset_error<E>();
+    using spilled = spilled_error<E>;
+    spilled *block = *std::launder(reinterpret_cast<spilled **>(aData.get()));
+    auto *resource = block->resource;
+    block->~spilled();
+    resource->deallocate(block, sizeof(spilled), alignof(spilled));
 }
 
+// Moves the error stored inline at aSrc to aDst and ends its lifetime at
+// aSrc.
 template <typename E>
-void copy_error(Dst aDst, Src aSrc) noexcept
+void relocate_error(Dst aDst, Dst aSrc) noexcept
 {
-    static_assert(std::is_nothrow_copy_constructible_v<E>);
+    static_assert(std::is_nothrow_move_constructible_v<E>);
     assert(utils::is_aligned<E>(aDst) &&
            "aDst is not aligned to contain value of type E");
     assert(utils::is_aligned<E>(aSrc) &&
            "aSrc is not aligned to contain value of type E");
-    new (aDst) E(*reinterpret_cast<E const *>(aSrc.get()));
+    E *src = std::launder(reinterpret_cast<E *>(aSrc.get()));
+    new (aDst) E(std::move(*src));
+    src->~E();
 }
+
+template <typename E, bool IsInline>
+inline constexpr vtable kVtable{
+    IsInline ? (std::is_trivially_destructible_v<E> ? nullptr
+                                                    : destroy_error<E>)
+             : destroy_spilled_error<E>,
+    IsInline && !std::is_trivially_copyable_v<E> ? relocate_error<E>
+                                                 : nullptr,
+    &type_name::kName<E>};
 }  // namespace error_ops
 }  // namespace details
 
+// Holds one error of any type. Errors of up to MaxSize bytes and MaxAlignment
+// alignment are stored inline, larger ones spill to error_spill::resource()
+// and the inline buffer keeps a pointer to them. When the resource can not
+// allocate, std::errc::not_enough_memory is held instead of the error.
 template <std::size_t MaxSize = sizeof(std::uint64_t),
           std::size_t MaxAlignment = alignof(std::uint64_t)>
 class error
 {
-    template <typename E, typename T>
-    friend void details::error_ops::destroy_error(T &) noexcept;
-
    public:
     static constexpr std::size_t kMaxSize = MaxSize;
     static constexpr std::size_t kMaxAlignment = MaxAlignment;
 
+    // the inline buffer always has room for the pointer to a spilled error
+    static constexpr std::size_t kInlineSize =
+        std::max(kMaxSize, sizeof(void *));
+    static constexpr std::size_t kInlineAlignment =
+        std::max(kMaxAlignment, alignof(void *));
+
+    template <typename E>
+    static constexpr bool is_inline =
+        sizeof(E) <= kInlineSize && alignof(E) <= kInlineAlignment;
+
+    // whether moving an error of type E is a memcpy of the inline buffer
+    template <typename E>
+    static constexpr bool is_trivially_relocatable =
+        !is_inline<E> || std::is_trivially_copyable_v<E>;
+
     ~error()
     {
         static_assert(utils::is_power_of_2(kMaxAlignment));
-        if (error_destroyer_)
+        if (vtable_)
         {
             reset();
         }
@@ -75,15 +194,10 @@ class error
     error(const error &aOther) = delete;
     error &operator=(const error &aOther) = delete;
 
-    error(error &&aOther) noexcept
-        : data_{}
-        , type_name_(std::cref(aOther.type_name_))
-        , error_destroyer_{aOther.error_destroyer_}
-        , error_copier_{aOther.error_copier_}
+    error(error &&aOther) noexcept : vtable_{aOther.vtable_}
     {
         assert(is_valid());
-        std::invoke(error_copier_, Dst(data_), Src(aOther.data_));
-        aOther.reset();
+        relocate_from(aOther);
     }
 
     error &operator=(error &&aOther) noexcept
@@ -94,118 +208,164 @@ class error
             assert(aOther.is_valid());
             reset();
 
-            error_destroyer_ = aOther.error_destroyer_;
-            error_copier_ = aOther.error_copier_;
-            type_name_ = std::cref(aOther.type_name_);
-            std::invoke(error_copier_, Dst(data_), Src(aOther.data_));
-            aOther.reset();
+            vtable_ = aOther.vtable_;
+            relocate_from(aOther);
         }
         return *this;
     }
 
+    // Takes over the error behind aOther, which may belong to a tricky::error
+    // of another size, in O(1): it is moved at most once and never
+    // allocated. accepts<...>(aOther) must hold.
+    explicit error(details::error_ops::view aOther) noexcept
+        : vtable_{*aOther.slot}
+    {
+        assert(is_valid());
+        if (vtable_->relocate)
+        {
+            vtable_->relocate(Dst(data_), Dst(aOther.data));
+        }
+        else
+        {
+            // the error or the pointer to it fits into both buffers
+            std::memcpy(data_, aOther.data, std::min(kInlineSize, aOther.size));
+        }
+        *aOther.slot = nullptr;
+    }
+
     template <typename E, typename error_t = utils::remove_cvref_t<E>>
-    error(E &&aError) noexcept
-        : data_()
-        , type_name_(std::cref(type_name::kName<error_t>))
-        , error_destroyer_(details::error_ops::destroy_error<error_t, error>)
-        , error_copier_(details::error_ops::copy_error<error_t>)
+    error(E &&aError) noexcept : vtable_(&vtable_of<error_t>)
     {
-        validate<error_t>();
         static_assert(std::is_nothrow_copy_constructible_v<error_t>);
         static_assert(std::is_nothrow_destructible_v<error_t>);
-        assert(is_valid());
-        new (data_) error_t(aError);
+        if constexpr (is_inline<error_t>)
+        {
+            new (data_) error_t(aError);
+        }
+        else
+        {
+            using spilled = details::error_ops::spilled_error<error_t>;
+            static_assert(is_inline<std::errc>);
+            auto *resource = error_spill::resource();
+            void *memory = details::error_ops::allocate_spilled(
+                resource, sizeof(spilled), alignof(spilled));
+            if (!memory)
+            {
+                vtable_ = &vtable_of<std::errc>;
+                new (data_) std::errc(std::errc::not_enough_memory);
+                return;
+            }
+            new (data_) spilled *(new (memory) spilled{resource, aError});
+        }
     }
 
     template <typename E>
     inline bool contains() const noexcept
     {
-        validate<E>();
-        return &type_name_.get() == &type_name::kName<E>;
+        return vtable_ == &vtable_of<E>;
     }
 
     inline const std::string_view &type_name() const noexcept
     {
-        return type_name_.get();
+        return vtable_ ? *vtable_->type_name : empty_;
     }
 
     template <typename E>
     E &value() noexcept
     {
         assert(contains<E>());
-        return *reinterpret_cast<E *>(data_);
+        return *get<E>();
     }
 
     template <typename E>
     const E &value() const noexcept
     {
         assert(contains<E>());
-        return *reinterpret_cast<E const *>(data_);
+        return *const_cast<error *>(this)->template get<E>();
     }
 
     template <typename E>
     E value() &&noexcept
     {
         assert(contains<E>());
-        return *reinterpret_cast<E *>(data_);
+        return *get<E>();
     }
 
     template <typename E>
     E value() const &&noexcept
     {
         assert(contains<E>());
-        return *reinterpret_cast<E const *>(data_);
+        return *const_cast<error *>(this)->template get<E>();
     }
 
     operator bool() const noexcept { return is_valid(); }
 
-   private:
-    using error_destroyer_t = details::error_ops::error_destroyer_t<error>;
-    using error_copier_t = details::error_ops::error_copier_t;
-    using Src = details::error_ops::Src;
-    using Dst = details::error_ops::Dst;
-
-    template <typename T>
-    static void validate() noexcept
+    details::error_ops::view view() noexcept
     {
-        static_assert(
-            sizeof(T) <= kMaxSize,
-            "Error: Not enough memory in data_ for placement value of type T");
-        static_assert(
-            alignof(T) <= kMaxAlignment,
-            "Error: data_ is not proper aligned for placement value of type T");
+        return {data_, kInlineSize, &vtable_};
     }
 
-    bool is_valid() const noexcept
+    // Whether the error behind aOther is one of Errors and stored here the
+    // same way as there: inline in both or spilled in both.
+    template <typename... Errors>
+    static bool accepts(details::error_ops::view aOther) noexcept
     {
-        return error_destroyer_ && error_copier_ &&
-               (&type_name_.get() != &empty_);
+        return (... || (*aOther.slot == &vtable_of<Errors>));
     }
 
+   private:
+    using vtable = details::error_ops::vtable;
+    using Dst = details::error_ops::Dst;
+
     template <typename E>
-    void reset_error() noexcept
+    static constexpr const vtable &vtable_of =
+        details::error_ops::kVtable<utils::remove_cvref_t<E>, is_inline<E>>;
+
+    template <typename E>
+    E *get() noexcept
     {
-        assert(contains<E>());
-        assert(error_destroyer_);
-        assert(error_copier_);
-        reinterpret_cast<E *>(data_)->~E();
-        error_destroyer_ = nullptr;
-        error_copier_ = nullptr;
-        type_name_ = std::cref(empty_);
+        if constexpr (is_inline<E>)
+        {
+            return std::launder(reinterpret_cast<E *>(data_));
+        }
+        else
+        {
+            using spilled = details::error_ops::spilled_error<E>;
+            spilled *block = *std::launder(reinterpret_cast<spilled **>(data_));
+            return &block->value;
+        }
+    }
+
+    bool is_valid() const noexcept { return vtable_; }
+
+    // takes over the error of aOther, which vtable_ already describes
+    void relocate_from(error &aOther) noexcept
+    {
+        if (vtable_->relocate)
+        {
+            vtable_->relocate(Dst(data_), Dst(aOther.data_));
+        }
+        else
+        {
+            std::memcpy(data_, aOther.data_, kInlineSize);
+        }
+        aOther.vtable_ = nullptr;
     }
 
     void reset() noexcept
     {
-        assert(error_destroyer_);
-        std::invoke(error_destroyer_, *this);
+        assert(vtable_);
+        if (vtable_->destroy)
+        {
+            vtable_->destroy(Dst(data_));
+        }
+        vtable_ = nullptr;
     }
 
-    static constexpr std::string_view empty_;
+    static constexpr std::string_view empty_{};
 
-    alignas(kMaxAlignment) std::byte data_[kMaxSize]{};
-    std::reference_wrapper<const std::string_view> type_name_;
-    error_destroyer_t error_destroyer_{nullptr};
-    error_copier_t error_copier_{nullptr};
+    alignas(kInlineAlignment) std::byte data_[kInlineSize];
+    const vtable *vtable_{nullptr};
 };
 }  // namespace tricky
 
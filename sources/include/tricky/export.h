@@ -0,0 +1,23 @@
+#ifndef tricky_export_h
+#define tricky_export_h
+
+// With TRICKY_STATE_DSO the error state and the active polymorphic_context
+// are not inline variables of every module but are defined once, in the
+// shared library built by tricky_add_state_library(). That library defines
+// TRICKY_STATE_EXPORT and every module of the process uses its copy, also
+// when built with hidden visibility.
+#ifdef TRICKY_STATE_DSO
+#ifdef _WIN32
+#ifdef TRICKY_STATE_EXPORT
+#define TRICKY_STATE_API __declspec(dllexport)
+#else
+#define TRICKY_STATE_API __declspec(dllimport)
+#endif
+#else
+#define TRICKY_STATE_API __attribute__((visibility("default")))
+#endif
+#else
+#define TRICKY_STATE_API
+#endif
+
+#endif /* tricky_export_h */
@@ -3,29 +3,16 @@
 
 #include <utils/utils.h>
 
+#include <array>
+#include <cstdint>
 #include <type_traits>
 #include <utility>
 
 #include "state.h"
+#include "storage.h"
 
 namespace tricky
 {
-template <typename T, typename Error, typename... Errors>
-class result;
-
-template <typename T>
-struct is_result : std::false_type
-{
-};
-
-template <typename T, typename Error, typename... Errors>
-struct is_result<result<T, Error, Errors...>> : std::true_type
-{
-};
-
-template <typename T>
-inline constexpr bool is_result_v = is_result<T>::value;
-
 namespace details
 {
 template <typename Callable, typename... Es>
@@ -106,8 +93,7 @@ struct values_handler
         }
         static_assert(not error_values::contains_copies,
                       "Errors must not contain copies.");
-        static_assert(error_categories::template count_of_predicate_compliant<
-                          std::is_enum> == error_categories::size,
+        static_assert(std::conjunction_v<std::is_enum<decltype(Errors)>...>,
                       "all Errors must belong to enum type.");
     }
 
@@ -246,30 +232,325 @@ struct ret_type
 template <typename T>
 using ret_type_t = typename ret_type<T>::type;
 
-template <typename... Handlers>
-class handlers_base : public Handlers...
+// Values of E listed by one source of sorted_values: a utils::value_list or a
+// values_handler. Other handlers list none.
+template <typename E, typename Source>
+struct listed_values
 {
-   protected:
-    using handlers_list = utils::type_list<Handlers...>;
-    using return_type =
-        typename utils::type_list<ret_type_t<Handlers>...>::template at<0>;
+    static constexpr std::size_t size = 0;
 
-    template <auto Error>
-    struct can_handle_error
+    template <typename Entries>
+    static constexpr void append(Entries &, std::size_t &,
+                                 std::size_t) noexcept
     {
-        template <typename H>
-        struct impl : std::false_type
+    }
+};
+
+template <typename E, auto... Values>
+struct listed_values<E, utils::value_list<Values...>>
+{
+    static constexpr std::size_t size =
+        (std::size_t{} + ... +
+         std::size_t{std::is_same_v<E, decltype(Values)>});
+
+    // one pass over plain arrays instead of one instantiation per value
+    template <typename Entries>
+    static constexpr void append([[maybe_unused]] Entries &aEntries,
+                                 [[maybe_unused]] std::size_t &aCount,
+                                 [[maybe_unused]] std::size_t aSource) noexcept
+    {
+        if constexpr (size > 0)
         {
-        };
+            using underlying_type = std::underlying_type_t<E>;
+            constexpr bool kMatches[] = {
+                std::is_same_v<E, decltype(Values)>...};
+            constexpr underlying_type kValues[] = {static_cast<underlying_type>(
+                utils::to_underlying(Values))...};
+            for (std::size_t i = 0; i < sizeof...(Values); ++i)
+            {
+                if (kMatches[i])
+                {
+                    aEntries[aCount++] = {kValues[i], aSource};
+                }
+            }
+        }
+    }
+};
 
-        template <typename H, auto... Errors>
-        struct impl<values_handler<H, Errors...>>
-            : std::bool_constant<
-                  utils::value_list<Errors...>::template contains_v<Error>>
+template <typename E, typename H, auto... Errors>
+struct listed_values<E, values_handler<H, Errors...>>
+    : listed_values<E, utils::value_list<Errors...>>
+{
+};
+
+// Underlying values of E listed by Sources, in ascending order, together with
+// the position in Sources of the source of every value. handlers_base passes
+// its handlers as Sources to get a flat value -> handler lookup.
+template <typename E, typename... Sources>
+struct sorted_values
+{
+    using underlying_type = std::underlying_type_t<E>;
+
+    static constexpr std::size_t size =
+        (std::size_t{} + ... + listed_values<E, Sources>::size);
+
+    struct entry
+    {
+        underlying_type value;
+        std::size_t source;
+    };
+
+    using entries_type = std::array<entry, size>;
+    using array_type = std::array<underlying_type, size>;
+    using sources_type = std::array<std::size_t, size>;
+
+    static constexpr entries_type make_entries() noexcept
+    {
+        entries_type entries{};
+        std::size_t count = 0;
+        std::size_t source = 0;
+        (..., listed_values<E, Sources>::append(entries, count, source++));
+        for (std::size_t i = 1; i < size; ++i)
         {
-        };
+            for (std::size_t j = i;
+                 j > 0 && entries[j].value < entries[j - 1].value; --j)
+            {
+                const auto tmp = entries[j];
+                entries[j] = entries[j - 1];
+                entries[j - 1] = tmp;
+            }
+        }
+        return entries;
+    }
+
+    static constexpr entries_type entries = make_entries();
+
+    static constexpr array_type make() noexcept
+    {
+        array_type values{};
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            values[i] = entries[i].value;
+        }
+        return values;
+    }
+
+    static constexpr sources_type make_sources() noexcept
+    {
+        sources_type sources{};
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            sources[i] = entries[i].source;
+        }
+        return sources;
+    }
+
+    static constexpr array_type values = make();
+
+    static constexpr sources_type sources = make_sources();
+
+    static constexpr bool has_copies() noexcept
+    {
+        for (std::size_t i = 1; i < size; ++i)
+        {
+            if (values[i] == values[i - 1])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static constexpr bool contains_copies = has_copies();
+
+    // distance between the smallest and the largest value
+    static constexpr std::uintmax_t span =
+        size ? static_cast<std::uintmax_t>(values[size - 1]) -
+                   static_cast<std::uintmax_t>(values[0])
+             : 0;
+
+    // distance of aValue from the smallest value, above span if out of range
+    static constexpr std::uintmax_t offset_of(underlying_type aValue) noexcept
+    {
+        return static_cast<std::uintmax_t>(aValue) -
+               static_cast<std::uintmax_t>(values[0]);
+    }
+
+    static constexpr underlying_type value_at(std::uintmax_t aOffset) noexcept
+    {
+        return static_cast<underlying_type>(
+            static_cast<std::uintmax_t>(values[0]) + aOffset);
+    }
+
+    // position of aValue in values or size if there is no such value
+    static constexpr std::size_t index_of(underlying_type aValue) noexcept
+    {
+        std::size_t first = 0;
+        std::size_t last = size;
+        while (first < last)
+        {
+            const std::size_t middle = first + (last - first) / 2;
+            if (values[middle] < aValue)
+            {
+                first = middle + 1;
+            }
+            else
+            {
+                last = middle;
+            }
+        }
+        return (first < size && values[first] == aValue) ? first : size;
+    }
+};
+
+// Multiplicative hash (value * multiplier) >> (64 - bits) which sends every
+// value of Values (a sorted_values) to its own slot of a 2^bits table, if
+// such a multiplier was found within kMaxAttempts attempts.
+template <typename Values>
+struct perfect_hash
+{
+    using underlying_type = typename Values::underlying_type;
+
+    static constexpr std::size_t kMaxAttempts = 256;
+
+    struct params
+    {
+        std::uint64_t multiplier;
+        unsigned bits;
+        bool found;
     };
 
+    static constexpr std::size_t slot(underlying_type aValue,
+                                      std::uint64_t aMultiplier,
+                                      unsigned aBits) noexcept
+    {
+        const auto kValue = static_cast<std::uint64_t>(aValue);
+        return aBits ? static_cast<std::size_t>((kValue * aMultiplier) >>
+                                                (64u - aBits))
+                     : 0;
+    }
+
+    static constexpr params find() noexcept
+    {
+        unsigned min_bits = 0;
+        while ((std::size_t{1} << min_bits) < Values::size)
+        {
+            ++min_bits;
+        }
+        for (unsigned bits = min_bits; bits <= min_bits + 1; ++bits)
+        {
+            std::uint64_t multiplier = 0x9e37'79b9'7f4a'7c15u;
+            for (std::size_t attempt = 0; attempt < kMaxAttempts; ++attempt)
+            {
+                std::array<bool, 4 * Values::size> used{};
+                bool is_perfect = true;
+                for (std::size_t i = 0; is_perfect && i < Values::size; ++i)
+                {
+                    const std::size_t kSlot =
+                        slot(Values::values[i], multiplier, bits);
+                    is_perfect = !used[kSlot];
+                    used[kSlot] = true;
+                }
+                if (is_perfect)
+                {
+                    return {multiplier, bits, true};
+                }
+                multiplier = (multiplier * 6'364'136'223'846'793'005u +
+                              1'442'695'040'888'963'407u) |
+                             1u;
+            }
+        }
+        return {0, 0, false};
+    }
+
+    static constexpr params kParams = find();
+
+    using slots_type =
+        std::array<utils::uint_from_nbits_t<utils::bits_count(Values::size)>,
+                   std::size_t{1} << kParams.bits>;
+
+    static constexpr slots_type make_slots() noexcept
+    {
+        slots_type slots{};
+        for (auto &index: slots)
+        {
+            index = Values::size;
+        }
+        for (std::size_t i = 0; i < Values::size; ++i)
+        {
+            slots[slot(Values::values[i], kParams.multiplier, kParams.bits)] =
+                static_cast<typename slots_type::value_type>(i);
+        }
+        return slots;
+    }
+
+    static constexpr slots_type slots = make_slots();
+
+    // position of aValue in Values::values or Values::size if it is absent
+    static constexpr std::size_t index_of(underlying_type aValue) noexcept
+    {
+        const std::size_t kIndex =
+            slots[slot(aValue, kParams.multiplier, kParams.bits)];
+        return (kIndex < Values::size && Values::values[kIndex] == aValue)
+                   ? kIndex
+                   : Values::size;
+    }
+};
+
+enum class value_dispatch
+{
+    kTable,
+    kPerfectHash,
+    kBinarySearch
+};
+
+// A direct table over min..max of the handled values of one category is used
+// while it has at most this many entries per handled value. Sparser sets are
+// looked up through a perfect hash or, if none was found, by binary search.
+inline constexpr std::uintmax_t kMaxTableEntriesPerValue = 4;
+
+template <typename Values>
+constexpr value_dispatch choose_value_dispatch() noexcept
+{
+    if constexpr (Values::span < Values::size * kMaxTableEntriesPerValue)
+    {
+        return value_dispatch::kTable;
+    }
+    else if constexpr (perfect_hash<Values>::kParams.found)
+    {
+        return value_dispatch::kPerfectHash;
+    }
+    else
+    {
+        return value_dispatch::kBinarySearch;
+    }
+}
+
+template <typename Values>
+inline constexpr value_dispatch value_dispatch_v =
+    choose_value_dispatch<Values>();
+
+// Position of the first true of Matches or sizeof...(Matches) if there is none.
+template <bool... Matches>
+constexpr std::size_t first_match() noexcept
+{
+    constexpr bool kMatches[] = {Matches..., true};
+    std::size_t position = 0;
+    while (!kMatches[position])
+    {
+        ++position;
+    }
+    return position;
+}
+
+template <typename... Handlers>
+class handlers_base : public Handlers...
+{
+   protected:
+    using handlers_list = utils::type_list<Handlers...>;
+    using return_type =
+        typename utils::type_list<ret_type_t<Handlers>...>::template at<0>;
+
     template <typename Category>
     struct can_handle_category
     {
@@ -280,72 +561,157 @@ class handlers_base : public Handlers...
 
         template <typename H, typename... Categories>
         struct impl<categories_handler<H, Categories...>>
-            : std::bool_constant<utils::type_list<
-                  Categories...>::template contains_v<Category>>
+            : std::disjunction<std::is_same<Category, Categories>...>
         {
         };
     };
 
-    template <typename H>
-    struct error_values_list
+    static constexpr std::size_t kAnyHandlerCount =
+        (std::size_t{} + ... + std::size_t{is_any_handler_v<Handlers>});
+
+    // The values_handlers of the values of E. Every value is mapped to a slot,
+    // every slot to the position of its handler in Handlers..., so that one
+    // handler function is instantiated per handler and not per value.
+    template <typename E>
+    struct value_handlers
     {
-        using type = utils::value_list<>;
+        using values = sorted_values<E, Handlers...>;
+
+        static constexpr std::size_t count_handlers() noexcept
+        {
+            std::array<bool, sizeof...(Handlers)> used{};
+            std::size_t count = 0;
+            for (const auto kSource: values::sources)
+            {
+                count += !used[kSource];
+                used[kSource] = true;
+            }
+            return count;
+        }
+
+        static constexpr std::size_t size = count_handlers();
+
+        using slot_type = utils::uint_from_nbits_t<utils::bits_count(size)>;
+        using positions_type = std::array<std::size_t, size>;
+        using slots_type = std::array<slot_type, values::size>;
+
+        static constexpr positions_type make_positions() noexcept
+        {
+            positions_type positions{};
+            std::size_t count = 0;
+            for (std::size_t position = 0; position < sizeof...(Handlers);
+                 ++position)
+            {
+                for (const auto kSource: values::sources)
+                {
+                    if (kSource == position)
+                    {
+                        positions[count++] = position;
+                        break;
+                    }
+                }
+            }
+            return positions;
+        }
+
+        static constexpr positions_type positions = make_positions();
+
+        static constexpr slot_type slot_of(std::size_t aPosition) noexcept
+        {
+            slot_type slot = 0;
+            while (positions[slot] != aPosition)
+            {
+                ++slot;
+            }
+            return slot;
+        }
+
+        static constexpr slots_type make_slots() noexcept
+        {
+            slots_type slots{};
+            for (std::size_t i = 0; i < values::size; ++i)
+            {
+                slots[i] = slot_of(values::sources[i]);
+            }
+            return slots;
+        }
+
+        // slot of every value of values::values
+        static constexpr slots_type slots = make_slots();
     };
 
-    template <typename H, auto... Errors>
-    struct error_values_list<tricky::values_handler<H, Errors...>>
+    // slot of every value of E in min..max of the handled ones, kept apart from
+    // value_handlers as it is only built with value_dispatch::kTable
+    template <typename E>
+    struct value_table
     {
-        using type =
-            typename tricky::values_handler<H, Errors...>::error_values;
-    };
+        using handled = value_handlers<E>;
+        using values = typename handled::values;
+        using slot_type = typename handled::slot_type;
+        using table_type =
+            std::array<slot_type, static_cast<std::size_t>(values::span) + 1>;
 
-    template <typename H>
-    using error_values_list_t = typename error_values_list<H>::type;
+        static constexpr table_type make() noexcept
+        {
+            table_type table{};
+            for (auto &slot: table)
+            {
+                slot = static_cast<slot_type>(handled::size);
+            }
+            for (std::size_t i = 0; i < values::size; ++i)
+            {
+                table[static_cast<std::size_t>(values::offset_of(
+                    values::values[i]))] = handled::slots[i];
+            }
+            return table;
+        }
 
-    using error_values = utils::concatenate_t<error_values_list_t<Handlers>...>;
+        static constexpr table_type slots = make();
+    };
 
-    template <auto Error, typename R>
+    // handled errors of inline results never reached shared_state, so a
+    // pending shared error must survive them
+    template <typename R>
+    static constexpr void reset_state() noexcept
+    {
+        if constexpr (utils::remove_cvref_t<R>::kIsShared)
+        {
+            tricky::shared_state::reset();
+        }
+    }
+
+    template <std::size_t Position, typename E, typename R>
     constexpr return_type process_error_value(
-        [[maybe_unused]] R &&aResult) const noexcept
+        [[maybe_unused]] E aError) const noexcept
     {
-        using matched_handlers =
-            typename handlers_list::template list_of_predicate_compliant_t<
-                can_handle_error<Error>::template impl>;
-        if constexpr (matched_handlers::size)
+        using value_handler = typename handlers_list::template at<Position>;
+        if constexpr (std::is_same_v<return_type, void>)
         {
-            using value_handler = typename matched_handlers::template at<0>;
-            if constexpr (std::is_same_v<return_type, void>)
+            if constexpr (std::conjunction_v<std::is_nothrow_invocable<
+                              typename value_handler::handler_type>>)
             {
-                if constexpr (std::conjunction_v<std::is_nothrow_invocable<
-                                  typename value_handler::handler_type>>)
-                {
-                    value_handler::handler();
-                }
-                else
-                {
-                    value_handler::handler(Error);
-                }
-                tricky::shared_state::reset();
+                value_handler::handler();
             }
             else
             {
-                return_type retVal{};
-                if constexpr (std::conjunction_v<std::is_nothrow_invocable<
-                                  typename value_handler::handler_type>>)
-                {
-                    retVal = value_handler::handler();
-                }
-                else
-                {
-                    retVal = value_handler::handler(Error);
-                }
-                tricky::shared_state::reset();
-                return std::move(retVal);
+                value_handler::handler(aError);
             }
+            reset_state<R>();
         }
         else
         {
-            return process_error_category(std::forward<R>(aResult), Error);
+            return_type retVal{};
+            if constexpr (std::conjunction_v<std::is_nothrow_invocable<
+                              typename value_handler::handler_type>>)
+            {
+                retVal = value_handler::handler();
+            }
+            else
+            {
+                retVal = value_handler::handler(aError);
+            }
+            reset_state<R>();
+            return std::move(retVal);
         }
     }
 
@@ -353,21 +719,21 @@ class handlers_base : public Handlers...
     constexpr return_type process_error_category([[maybe_unused]] R &&aResult,
                                                  Category aError) const noexcept
     {
-        using matched_handlers =
-            typename handlers_list::template list_of_predicate_compliant_t<
-                can_handle_category<Category>::template impl>;
-        if constexpr (matched_handlers::size)
+        constexpr std::size_t kPosition = first_match<
+            can_handle_category<Category>::template impl<Handlers>::value...>();
+        if constexpr (kPosition < sizeof...(Handlers))
         {
-            using category_handler = typename matched_handlers::template at<0>;
+            using category_handler =
+                typename handlers_list::template at<kPosition>;
             if constexpr (std::is_same_v<return_type, void>)
             {
                 category_handler::handler(aError);
-                tricky::shared_state::reset();
+                reset_state<R>();
             }
             else
             {
                 auto retVal = category_handler::handler(aError);
-                tricky::shared_state::reset();
+                reset_state<R>();
                 return std::move(retVal);
             }
         }
@@ -382,21 +748,21 @@ class handlers_base : public Handlers...
         [[maybe_unused]] R &&aResult,
         [[maybe_unused]] Category aError) const noexcept
     {
-        using matched_handlers =
-            typename handlers_list::template list_of_predicate_compliant_t<
-                is_any_handler>;
-        if constexpr (matched_handlers::size)
+        constexpr std::size_t kPosition =
+            first_match<is_any_handler_v<Handlers>...>();
+        if constexpr (kPosition < sizeof...(Handlers))
         {
-            using any_error_handler = typename matched_handlers::template at<0>;
+            using any_error_handler =
+                typename handlers_list::template at<kPosition>;
             if constexpr (std::is_same_v<return_type, void>)
             {
                 any_error_handler::handler(aError);
-                tricky::shared_state::reset();
+                reset_state<R>();
             }
             else
             {
                 auto retVal = any_error_handler::handler(aError);
-                tricky::shared_state::reset();
+                reset_state<R>();
                 return std::move(retVal);
             }
         }
@@ -412,16 +778,20 @@ class handlers_base : public Handlers...
         using type = return_type (handlers_base::*)(Result &&) const noexcept;
     };
 
-    template <typename E, typename IntervalT, typename R, std::size_t... I>
+    template <typename E>
+    using error_value_func = return_type (handlers_base::*)(E) const noexcept;
+
+    // handlers of the values of E, one per slot of value_handlers<E>
+    template <typename E, typename R, std::size_t... I>
+    static constexpr error_value_func<E> kValueHandlers[] = {
+        &handlers_base::process_error_value<
+            value_handlers<E>::positions[I], E, R>...};
+
+    template <typename R, typename E, std::size_t... I>
     constexpr return_type call_value_handler(
-        R &&aResult, std::size_t aIndex,
-        std::index_sequence<I...>) const noexcept
-    {
-        using value_handler_func_t = typename value_handler_func<R>::type;
-        value_handler_func_t handlers[sizeof...(I)]{
-            &handlers_base::process_error_value<
-                static_cast<E>(IntervalT::valueAt(I)), R>...};
-        return (this->*handlers[aIndex])(std::forward<R>(aResult));
+        E aError, std::size_t aSlot, std::index_sequence<I...>) const noexcept
+    {
+        return (this->*kValueHandlers<E, R, I...>[aSlot])(aError);
     }
 
     handlers_base() = delete;
@@ -435,40 +805,58 @@ class handlers_base : public Handlers...
     template <typename E, typename R>
     constexpr return_type process_error_in_result(R &&aResult) const noexcept
     {
-        static_assert(not error_values::contains_copies,
+        using values = sorted_values<E, Handlers...>;
+        static_assert(not values::contains_copies,
                       "duplications of error values is not allowed.");
 
         const auto kError = aResult.template error<E>();
-        if constexpr (error_values::template contains_type<E>)
+        if constexpr (values::size > 0)
         {
-            constexpr E kMin = error_values::template min<E>;
-            constexpr E kMax = error_values::template max<E>;
-
-            using interval_type =
-                interval::Interval<interval::Min<utils::to_underlying(kMin)>,
-                                   interval::Max<utils::to_underlying(kMax)>>;
-            constexpr std::size_t kCount = interval_type::kMaxIndex + 1_uz;
+            constexpr value_dispatch kDispatch = value_dispatch_v<values>;
+            using handled = value_handlers<E>;
             const auto kErrorAsIntegral = utils::to_underlying(kError);
-
-            if (interval_type::contains(kErrorAsIntegral))
+            std::size_t slot = handled::size;
+            if constexpr (kDispatch == value_dispatch::kTable)
             {
-                const std::size_t kIndex =
-                    interval_type::indexOf(kErrorAsIntegral);
-                return call_value_handler<E, interval_type>(
-                    std::forward<R>(aResult), kIndex,
-                    std::make_index_sequence<kCount>{});
+                const std::uintmax_t kOffset =
+                    values::offset_of(kErrorAsIntegral);
+                if (kOffset <= values::span)
+                {
+                    constexpr auto &kSlots = value_table<E>::slots;
+                    slot = kSlots[static_cast<std::size_t>(kOffset)];
+                }
             }
             else
             {
-                return process_error_category(std::forward<R>(aResult), kError);
+                std::size_t index = values::size;
+                if constexpr (kDispatch == value_dispatch::kPerfectHash)
+                {
+                    index = perfect_hash<values>::index_of(kErrorAsIntegral);
+                }
+                else
+                {
+                    index = values::index_of(kErrorAsIntegral);
+                }
+                if (index != values::size)
+                {
+                    slot = handled::slots[index];
+                }
+            }
+            if (slot != handled::size)
+            {
+                return call_value_handler<R>(
+                    kError, slot, std::make_index_sequence<handled::size>{});
             }
         }
-        else
-        {
-            return process_error_category(std::forward<R>(aResult), kError);
-        }
+        return process_error_category(std::forward<R>(aResult), kError);
     }
 
+    template <typename R, std::size_t... I>
+    static constexpr typename value_handler_func<R>::type kCategoryHandlers[] =
+        {&handlers_base::process_error_in_result<
+            typename utils::remove_cvref_t<R>::error_types::template at<I>,
+            R>...};
+
     template <typename R, std::size_t... I>
     constexpr return_type process_impl(R &&aResult,
                                        std::index_sequence<I...>) const noexcept
@@ -476,11 +864,9 @@ class handlers_base : public Handlers...
         using ResultT = utils::remove_cvref_t<R>;
         static_assert(is_result_v<ResultT>);
 
-        if constexpr (handlers_list::template contains_predicate_compliant<
-                          is_any_handler>)
+        if constexpr (kAnyHandlerCount > 0)
         {
-            static_assert(handlers_list::template count_of_predicate_compliant<
-                              is_any_handler> == 1);
+            static_assert(kAnyHandlerCount == 1);
             static_assert(
                 std::is_same_v<return_type, typename ResultT::value_type>);
         }
@@ -491,12 +877,8 @@ class handlers_base : public Handlers...
 
         if (aResult.has_error())
         {
-            using value_handler_func_t = typename value_handler_func<R>::type;
-            constexpr value_handler_func_t callbacks[sizeof...(I)] = {
-                &handlers_base::process_error_in_result<
-                    typename ResultT::error_types::template at<I>,
-                    decltype(aResult)>...};
-            return (this->*callbacks[tricky::shared_state::type_index() - 1])(
+            constexpr auto &kHandlers = kCategoryHandlers<R, I...>;
+            return (this->*kHandlers[aResult.type_index() - 1])(
                 std::forward<R>(aResult));
         }
         else
@@ -507,7 +889,7 @@ class handlers_base : public Handlers...
             }
             else if constexpr (not std::is_same_v<return_type, void>)
             {
-                return aResult.value();
+                return std::forward<R>(aResult).value();
             }
         }
     }
@@ -2,12 +2,79 @@
 #define tricky_lazy_load_h
 
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "state.h"
 
 namespace tricky
 {
+// A payload value which is built on the failure path only: on_error() calls
+// its producer, a noexcept callable without arguments, when the state has an
+// error and loads what it returns. A producer returning void loads the
+// payload by itself. Made by defer().
+template <typename F>
+class deferred
+{
+    static_assert(std::is_nothrow_invocable_v<F &>,
+                  "producer must be a noexcept callable without arguments");
+
+   public:
+    explicit deferred(F aProducer) noexcept(
+        std::is_nothrow_move_constructible_v<F>)
+        : producer_(std::move(aProducer))
+    {
+    }
+
+    void load() noexcept
+    {
+        if constexpr (std::is_void_v<std::invoke_result_t<F &>>)
+        {
+            producer_();
+        }
+        else
+        {
+            shared_state::load(producer_());
+        }
+    }
+
+   private:
+    F producer_;
+};
+
+template <typename F>
+[[nodiscard]] inline deferred<std::decay_t<F>> defer(F &&aProducer) noexcept(
+    std::is_nothrow_constructible_v<std::decay_t<F>, F &&>)
+{
+    return deferred<std::decay_t<F>>(std::forward<F>(aProducer));
+}
+
+namespace details
+{
+template <typename T>
+struct is_deferred : std::false_type
+{
+};
+
+template <typename F>
+struct is_deferred<deferred<F>> : std::true_type
+{
+};
+
+template <typename T>
+void load_item(T &&aItem) noexcept
+{
+    if constexpr (is_deferred<std::decay_t<T>>::value)
+    {
+        aItem.load();
+    }
+    else
+    {
+        shared_state::load(std::forward<T>(aItem));
+    }
+}
+}  // namespace details
+
 template <typename... Ts>
 class lazy_load
 {
@@ -45,13 +112,15 @@ class lazy_load
     static void preload_each_tuple_item(T &&aTuple,
                                         std::index_sequence<I...>) noexcept
     {
-        (..., shared_state::load(std::get<I>(std::forward<T>(aTuple))));
+        (..., details::load_item(std::get<I>(std::forward<T>(aTuple))));
     }
 
     std::tuple<Ts...> cargo_;
     bool moved_{};
 };
 
+// Values are loaded as is, values wrapped into defer() are built on the
+// failure path only; both kinds may be mixed.
 template <typename... Ts>
 [[nodiscard]] inline decltype(auto) on_error(Ts &&...aForPayload) noexcept
 {
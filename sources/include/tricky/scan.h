@@ -0,0 +1,605 @@
+#ifndef tricky_scan_h
+#define tricky_scan_h
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+    (defined(__i386__) && defined(__SSE2__))
+#define TRICKY_SCAN_X86
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// AVX2 kernels exist when the whole build targets AVX2 or, with
+// TRICKY_SCAN_RUNTIME_DISPATCH, when GCC/Clang can compile them for AVX2
+// alone and pick them after checking the CPU.
+#if defined(TRICKY_SCAN_X86) && defined(__AVX2__)
+#define TRICKY_SCAN_AVX2
+#define TRICKY_SCAN_AVX2_TARGET
+#elif defined(TRICKY_SCAN_X86) && defined(TRICKY_SCAN_RUNTIME_DISPATCH) && \
+    defined(__GNUC__)
+#define TRICKY_SCAN_AVX2
+#define TRICKY_SCAN_AVX2_DISPATCH
+#define TRICKY_SCAN_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace tricky
+{
+#ifdef TRICKY_SCAN_RUNTIME_DISPATCH
+inline constexpr bool kScanRuntimeDispatch = true;
+#else
+inline constexpr bool kScanRuntimeDispatch = false;
+#endif
+
+// Instruction sets the scans over type indices can run on.
+enum class scan_isa : std::uint8_t
+{
+    kScalar,
+    kSSE2,
+    kAVX2
+};
+
+// Whether kernels for aIsa are compiled in and the CPU can run them.
+inline bool scan_isa_supported(scan_isa aIsa) noexcept
+{
+    switch (aIsa)
+    {
+        case scan_isa::kScalar:
+            return true;
+#ifdef TRICKY_SCAN_X86
+        case scan_isa::kSSE2:
+            return true;
+#endif
+#if defined(TRICKY_SCAN_AVX2_DISPATCH)
+        case scan_isa::kAVX2:
+        {
+            static const bool supported = __builtin_cpu_supports("avx2");
+            return supported;
+        }
+#elif defined(TRICKY_SCAN_AVX2)
+        case scan_isa::kAVX2:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+// The widest supported instruction set: fixed at compile time unless
+// TRICKY_SCAN_RUNTIME_DISPATCH is defined.
+inline scan_isa best_scan_isa() noexcept
+{
+#if defined(TRICKY_SCAN_AVX2_DISPATCH)
+    static const scan_isa isa = scan_isa_supported(scan_isa::kAVX2)
+                                    ? scan_isa::kAVX2
+                                    : scan_isa::kSSE2;
+    return isa;
+#elif defined(TRICKY_SCAN_AVX2)
+    return scan_isa::kAVX2;
+#elif defined(TRICKY_SCAN_X86)
+    return scan_isa::kSSE2;
+#else
+    return scan_isa::kScalar;
+#endif
+}
+
+namespace details
+{
+inline unsigned count_trailing_zeros(std::uint32_t aMask) noexcept
+{
+    assert(aMask && "count_trailing_zeros(0) is undefined");
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, aMask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(aMask));
+#endif
+}
+
+constexpr unsigned count_ones(std::uint32_t aMask) noexcept
+{
+    aMask = aMask - ((aMask >> 1) & 0x55555555u);
+    aMask = (aMask & 0x33333333u) + ((aMask >> 2) & 0x33333333u);
+    return (((aMask + (aMask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+// Fallback for every index type; also finishes the tails of the SIMD
+// kernels.
+struct scalar_scan
+{
+    template <typename Index>
+    static bool contains_error(const Index *aIndices,
+                               std::size_t aSize) noexcept
+    {
+        constexpr std::size_t kBlock = 64;
+        std::size_t i = 0;
+        for (; i + kBlock <= aSize; i += kBlock)
+        {
+            Index any = 0;
+            for (std::size_t j = 0; j < kBlock; ++j)
+            {
+                any |= aIndices[i + j];
+            }
+            if (any)
+            {
+                return true;
+            }
+        }
+        Index any = 0;
+        for (; i < aSize; ++i)
+        {
+            any |= aIndices[i];
+        }
+        return any;
+    }
+
+    template <typename Index>
+    static std::size_t find_first_error(const Index *aIndices,
+                                        std::size_t aSize) noexcept
+    {
+        return static_cast<std::size_t>(
+            std::find_if(aIndices, aIndices + aSize,
+                         [](Index aIndex) noexcept { return aIndex != 0; }) -
+            aIndices);
+    }
+
+    template <std::size_t N, typename Index>
+    static void count(const Index *aIndices, std::size_t aSize,
+                      std::size_t *aCounts) noexcept
+    {
+        for (std::size_t i = 0; i < aSize; ++i)
+        {
+            assert(aIndices[i] < N && "index out of range");
+            ++aCounts[aIndices[i]];
+        }
+    }
+
+    template <typename T, typename Index>
+    static std::size_t compress(const T *aValues, const Index *aIndices,
+                                std::size_t aSize, T *aOut)
+    {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < aSize; ++i)
+        {
+            if constexpr (std::is_trivially_copyable_v<T>)
+            {
+                // branchless: the slot is overwritten unless it was a value
+                aOut[count] = aValues[i];
+                count += aIndices[i] == 0;
+            }
+            else if (!aIndices[i])
+            {
+                aOut[count++] = aValues[i];
+            }
+        }
+        return count;
+    }
+};
+
+#ifdef TRICKY_SCAN_X86
+// SSE2 kernels over 8-bit indices, 16 lanes at a time.
+struct sse2_scan
+{
+    static __m128i load(const std::uint8_t *aIndices) noexcept
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(aIndices));
+    }
+
+    // bit i is set when lane i holds a value
+    static std::uint32_t value_mask(const std::uint8_t *aIndices) noexcept
+    {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(load(aIndices), _mm_setzero_si128())));
+    }
+
+    static bool contains_error(const std::uint8_t *aIndices,
+                               std::size_t aSize) noexcept
+    {
+        std::size_t i = 0;
+        for (; i + 64 <= aSize; i += 64)
+        {
+            const __m128i any =
+                _mm_or_si128(_mm_or_si128(load(aIndices + i),
+                                          load(aIndices + i + 16)),
+                             _mm_or_si128(load(aIndices + i + 32),
+                                          load(aIndices + i + 48)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) !=
+                0xFFFF)
+            {
+                return true;
+            }
+        }
+        return scalar_scan::contains_error(aIndices + i, aSize - i);
+    }
+
+    static std::size_t find_first_error(const std::uint8_t *aIndices,
+                                        std::size_t aSize) noexcept
+    {
+        std::size_t i = 0;
+        for (; i + 16 <= aSize; i += 16)
+        {
+            const std::uint32_t errors = ~value_mask(aIndices + i) & 0xFFFFu;
+            if (errors)
+            {
+                return i + count_trailing_zeros(errors);
+            }
+        }
+        return i + scalar_scan::find_first_error(aIndices + i, aSize - i);
+    }
+
+    // 8-bit counters of every category are flushed every 255 blocks
+    template <std::size_t N>
+    static void count(const std::uint8_t *aIndices, std::size_t aSize,
+                      std::size_t *aCounts) noexcept
+    {
+        std::size_t i = 0;
+        while (i + 16 <= aSize)
+        {
+            const std::size_t end =
+                i + 16 * std::min<std::size_t>(255, (aSize - i) / 16);
+            __m128i counters[N - 1];
+            for (__m128i &counter: counters)
+            {
+                counter = _mm_setzero_si128();
+            }
+            for (; i < end; i += 16)
+            {
+                const __m128i indices = load(aIndices + i);
+                for (std::size_t c = 0; c < N - 1; ++c)
+                {
+                    // a match is -1, so subtracting it counts up
+                    counters[c] = _mm_sub_epi8(
+                        counters[c],
+                        _mm_cmpeq_epi8(indices, _mm_set1_epi8(
+                                                    static_cast<char>(c + 1))));
+                }
+            }
+            for (std::size_t c = 0; c < N - 1; ++c)
+            {
+                alignas(16) std::uint64_t sums[2];
+                _mm_store_si128(reinterpret_cast<__m128i *>(sums),
+                                _mm_sad_epu8(counters[c], _mm_setzero_si128()));
+                aCounts[c + 1] += static_cast<std::size_t>(sums[0] + sums[1]);
+            }
+        }
+        scalar_scan::count<N>(aIndices + i, aSize - i, aCounts);
+    }
+
+    template <typename T>
+    static std::size_t compress(const T *aValues, const std::uint8_t *aIndices,
+                                std::size_t aSize, T *aOut)
+    {
+        std::size_t count = 0;
+        std::size_t i = 0;
+        for (; i + 16 <= aSize; i += 16)
+        {
+            std::uint32_t values = value_mask(aIndices + i);
+            if (values == 0xFFFFu)
+            {
+                std::copy_n(aValues + i, 16, aOut + count);
+                count += 16;
+                continue;
+            }
+            for (; values; values &= values - 1)
+            {
+                aOut[count++] = aValues[i + count_trailing_zeros(values)];
+            }
+        }
+        return count + scalar_scan::compress(aValues + i, aIndices + i,
+                                             aSize - i, aOut + count);
+    }
+};
+#endif
+
+#ifdef TRICKY_SCAN_AVX2
+// vpermd indices moving the lanes set in a mask to the front
+struct compress_table
+{
+    alignas(32) std::uint32_t lanes[256][8];
+};
+
+constexpr compress_table make_compress_table() noexcept
+{
+    compress_table table{};
+    for (unsigned mask = 0; mask < 256; ++mask)
+    {
+        unsigned count = 0;
+        for (unsigned lane = 0; lane < 8; ++lane)
+        {
+            if (mask & (1u << lane))
+            {
+                table.lanes[mask][count++] = lane;
+            }
+        }
+    }
+    return table;
+}
+
+inline constexpr compress_table kCompressTable = make_compress_table();
+
+// AVX2 kernels over 8-bit indices, 32 lanes at a time.
+struct avx2_scan
+{
+    TRICKY_SCAN_AVX2_TARGET
+    static __m256i load(const void *aData) noexcept
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(aData));
+    }
+
+    // bit i is set when lane i holds a value
+    TRICKY_SCAN_AVX2_TARGET
+    static std::uint32_t value_mask(const std::uint8_t *aIndices) noexcept
+    {
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(load(aIndices), _mm256_setzero_si256())));
+    }
+
+    TRICKY_SCAN_AVX2_TARGET
+    static bool contains_error(const std::uint8_t *aIndices,
+                               std::size_t aSize) noexcept
+    {
+        std::size_t i = 0;
+        for (; i + 128 <= aSize; i += 128)
+        {
+            const __m256i any = _mm256_or_si256(
+                _mm256_or_si256(load(aIndices + i), load(aIndices + i + 32)),
+                _mm256_or_si256(load(aIndices + i + 64),
+                                load(aIndices + i + 96)));
+            if (!_mm256_testz_si256(any, any))
+            {
+                return true;
+            }
+        }
+        return sse2_scan::contains_error(aIndices + i, aSize - i);
+    }
+
+    TRICKY_SCAN_AVX2_TARGET
+    static std::size_t find_first_error(const std::uint8_t *aIndices,
+                                        std::size_t aSize) noexcept
+    {
+        std::size_t i = 0;
+        for (; i + 32 <= aSize; i += 32)
+        {
+            const std::uint32_t errors = ~value_mask(aIndices + i);
+            if (errors)
+            {
+                return i + count_trailing_zeros(errors);
+            }
+        }
+        return i + sse2_scan::find_first_error(aIndices + i, aSize - i);
+    }
+
+    template <std::size_t N>
+    TRICKY_SCAN_AVX2_TARGET static void count(const std::uint8_t *aIndices,
+                                              std::size_t aSize,
+                                              std::size_t *aCounts) noexcept
+    {
+        std::size_t i = 0;
+        while (i + 32 <= aSize)
+        {
+            const std::size_t end =
+                i + 32 * std::min<std::size_t>(255, (aSize - i) / 32);
+            __m256i counters[N - 1];
+            for (__m256i &counter: counters)
+            {
+                counter = _mm256_setzero_si256();
+            }
+            for (; i < end; i += 32)
+            {
+                const __m256i indices = load(aIndices + i);
+                for (std::size_t c = 0; c < N - 1; ++c)
+                {
+                    counters[c] = _mm256_sub_epi8(
+                        counters[c],
+                        _mm256_cmpeq_epi8(indices,
+                                          _mm256_set1_epi8(
+                                              static_cast<char>(c + 1))));
+                }
+            }
+            for (std::size_t c = 0; c < N - 1; ++c)
+            {
+                alignas(32) std::uint64_t sums[4];
+                _mm256_store_si256(
+                    reinterpret_cast<__m256i *>(sums),
+                    _mm256_sad_epu8(counters[c], _mm256_setzero_si256()));
+                aCounts[c + 1] +=
+                    static_cast<std::size_t>(sums[0] + sums[1] + sums[2] +
+                                             sums[3]);
+            }
+        }
+        sse2_scan::count<N>(aIndices + i, aSize - i, aCounts);
+    }
+
+    // 4-byte values are moved to the front of every 8 lanes with vpermd;
+    // the stores may run ahead of the result, but never past aOut + aSize.
+    template <typename T>
+    TRICKY_SCAN_AVX2_TARGET static std::size_t compress(
+        const T *aValues, const std::uint8_t *aIndices, std::size_t aSize,
+        T *aOut)
+    {
+        if constexpr (!std::is_trivially_copyable_v<T> || sizeof(T) != 4)
+        {
+            return sse2_scan::compress(aValues, aIndices, aSize, aOut);
+        }
+        else
+        {
+            std::size_t count = 0;
+            std::size_t i = 0;
+            for (; i + 32 <= aSize; i += 32)
+            {
+                const std::uint32_t values = value_mask(aIndices + i);
+                if (values == 0xFFFFFFFFu)
+                {
+                    std::memcpy(aOut + count, aValues + i, 32 * sizeof(T));
+                    count += 32;
+                    continue;
+                }
+                for (unsigned group = 0; group < 4; ++group)
+                {
+                    const std::uint32_t lanes = (values >> (8 * group)) & 0xFFu;
+                    const __m256i packed = _mm256_permutevar8x32_epi32(
+                        load(aValues + i + 8 * group),
+                        _mm256_load_si256(reinterpret_cast<const __m256i *>(
+                            kCompressTable.lanes[lanes])));
+                    _mm256_storeu_si256(
+                        reinterpret_cast<__m256i *>(aOut + count), packed);
+                    count += count_ones(lanes);
+                }
+            }
+            return count + sse2_scan::compress(aValues + i, aIndices + i,
+                                               aSize - i, aOut + count);
+        }
+    }
+};
+#endif
+
+// Counting with 8-bit SIMD counters costs one compare per category and
+// block, so many categories are better served by the scalar histogram.
+inline constexpr std::size_t kSimdCountMaxCategories = 16;
+}  // namespace details
+
+// Scans over the type indices of many results (see result_batch::indices()):
+// 0 marks a value, anything else an error. Arrays of 8-bit indices use the
+// SIMD kernels of aIsa, wider ones are always scanned by scalar code. aIsa
+// must be supported (see scan_isa_supported()).
+
+// Whether any of aSize indices is an error.
+template <typename Index>
+bool contains_error(const Index *aIndices, std::size_t aSize,
+                    scan_isa aIsa = best_scan_isa()) noexcept
+{
+    static_assert(std::is_unsigned_v<Index>, "Index must be unsigned");
+    assert(scan_isa_supported(aIsa) && "unsupported scan_isa");
+    if constexpr (std::is_same_v<Index, std::uint8_t>)
+    {
+        switch (aIsa)
+        {
+#ifdef TRICKY_SCAN_AVX2
+            case scan_isa::kAVX2:
+                return details::avx2_scan::contains_error(aIndices, aSize);
+#endif
+#ifdef TRICKY_SCAN_X86
+            case scan_isa::kSSE2:
+                return details::sse2_scan::contains_error(aIndices, aSize);
+#endif
+            default:
+                break;
+        }
+    }
+    return details::scalar_scan::contains_error(aIndices, aSize);
+}
+
+// Position of the first error or aSize if there is none.
+template <typename Index>
+std::size_t find_first_error(const Index *aIndices, std::size_t aSize,
+                             scan_isa aIsa = best_scan_isa()) noexcept
+{
+    static_assert(std::is_unsigned_v<Index>, "Index must be unsigned");
+    assert(scan_isa_supported(aIsa) && "unsupported scan_isa");
+    if constexpr (std::is_same_v<Index, std::uint8_t>)
+    {
+        switch (aIsa)
+        {
+#ifdef TRICKY_SCAN_AVX2
+            case scan_isa::kAVX2:
+                return details::avx2_scan::find_first_error(aIndices, aSize);
+#endif
+#ifdef TRICKY_SCAN_X86
+            case scan_isa::kSSE2:
+                return details::sse2_scan::find_first_error(aIndices, aSize);
+#endif
+            default:
+                break;
+        }
+    }
+    return details::scalar_scan::find_first_error(aIndices, aSize);
+}
+
+// Number of occurrences of every index below N; all indices must be below N.
+template <std::size_t N, typename Index>
+std::array<std::size_t, N> count_indices(
+    const Index *aIndices, std::size_t aSize,
+    scan_isa aIsa = best_scan_isa()) noexcept
+{
+    static_assert(std::is_unsigned_v<Index>, "Index must be unsigned");
+    static_assert(N > 1, "there must be at least one error category");
+    assert(scan_isa_supported(aIsa) && "unsupported scan_isa");
+    std::array<std::size_t, N> counts{};
+    if constexpr (std::is_same_v<Index, std::uint8_t> &&
+                  N <= details::kSimdCountMaxCategories)
+    {
+        switch (aIsa)
+        {
+#ifdef TRICKY_SCAN_AVX2
+            case scan_isa::kAVX2:
+                details::avx2_scan::count<N>(aIndices, aSize, counts.data());
+                break;
+#endif
+#ifdef TRICKY_SCAN_X86
+            case scan_isa::kSSE2:
+                details::sse2_scan::count<N>(aIndices, aSize, counts.data());
+                break;
+#endif
+            default:
+                details::scalar_scan::count<N>(aIndices, aSize,
+                                               counts.data());
+                return counts;
+        }
+        // the SIMD kernels count errors only
+        std::size_t errors = 0;
+        for (std::size_t c = 1; c < N; ++c)
+        {
+            errors += counts[c];
+        }
+        counts[0] = aSize - errors;
+    }
+    else
+    {
+        details::scalar_scan::count<N>(aIndices, aSize, counts.data());
+    }
+    return counts;
+}
+
+// Copies aValues[i] for every value lane i to aOut, in order, and returns
+// their number. aOut must have room for aSize values: slots past the result
+// may be overwritten.
+template <typename T, typename Index>
+std::size_t compress_values(const T *aValues, const Index *aIndices,
+                            std::size_t aSize, T *aOut,
+                            scan_isa aIsa = best_scan_isa())
+{
+    static_assert(std::is_unsigned_v<Index>, "Index must be unsigned");
+    assert(scan_isa_supported(aIsa) && "unsupported scan_isa");
+    if constexpr (std::is_same_v<Index, std::uint8_t>)
+    {
+        switch (aIsa)
+        {
+#ifdef TRICKY_SCAN_AVX2
+            case scan_isa::kAVX2:
+                return details::avx2_scan::compress(aValues, aIndices, aSize,
+                                                    aOut);
+#endif
+#ifdef TRICKY_SCAN_X86
+            case scan_isa::kSSE2:
+                return details::sse2_scan::compress(aValues, aIndices, aSize,
+                                                    aOut);
+#endif
+            default:
+                break;
+        }
+    }
+    return details::scalar_scan::compress(aValues, aIndices, aSize, aOut);
+}
+}  // namespace tricky
+
+#endif /* tricky_scan_h */
@@ -2,6 +2,17 @@
 #define tricky_state_h
 #include <cargo/cargo.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "arena.h"
+#include "export.h"
+
 namespace tricky
 {
 #ifdef TRICKY_PAYLOAD_MAXSPACE
@@ -10,17 +21,183 @@ inline constexpr std::size_t kPayloadMaxSpace = TRICKY_PAYLOAD_MAXSPACE;
 inline constexpr std::size_t kPayloadMaxSpace = 256;
 #endif
 
+#ifdef TRICKY_PAYLOAD_ARENA
+inline constexpr bool kPayloadArena = true;
+#else
+inline constexpr bool kPayloadArena = false;
+#endif
+
+#ifdef TRICKY_PAYLOAD_STATS
+inline constexpr bool kPayloadStats = true;
+#else
+inline constexpr bool kPayloadStats = false;
+#endif
+
+#ifdef TRICKY_THREAD_LOCAL_STATE
+#define TRICKY_STATE_STORAGE thread_local
+inline constexpr bool kThreadLocalState = true;
+#else
+#define TRICKY_STATE_STORAGE
+inline constexpr bool kThreadLocalState = false;
+#endif
+
+#if defined(TRICKY_STATE_DSO) &&                                        \
+    (defined(TRICKY_THREAD_LOCAL_STATE) || defined(TRICKY_COROUTINES)) && \
+    defined(_WIN32)
+#error "thread-local state cannot be exported from a DLL"
+#endif
+
+#ifdef TRICKY_COROUTINES
+inline constexpr bool kSwitchableState = true;
+#else
+inline constexpr bool kSwitchableState = false;
+#endif
+
+// Payload statistics of a state since it was created or its statistics
+// were cleared. All zero unless TRICKY_PAYLOAD_STATS is defined. Bytes
+// are those the payload uses for the values, not their sizeof.
+struct payload_stats
+{
+    std::uint64_t loads{};           // values passed to load()
+    std::uint64_t rejected_loads{};  // values which did not fit
+    std::uint64_t bytes_loaded{};
+    std::uint64_t bytes_rejected{};
+    std::size_t high_water_mark{};  // most bytes held by a single payload
+};
+
 namespace details
 {
+class payload_counter
+{
+   public:
+    void on_load(bool aStored, std::size_t aSize) noexcept
+    {
+        ++stats_.loads;
+        if (aStored)
+        {
+            stats_.bytes_loaded += aSize;
+            bytes_ += aSize;
+            if (bytes_ > stats_.high_water_mark)
+            {
+                stats_.high_water_mark = bytes_;
+            }
+        }
+        else
+        {
+            ++stats_.rejected_loads;
+            stats_.bytes_rejected += aSize;
+        }
+    }
+
+    void on_reset() noexcept { bytes_ = 0; }
+
+    const payload_stats &stats() const noexcept { return stats_; }
+
+    void clear() noexcept { stats_ = {}; }
+
+   private:
+    payload_stats stats_;
+    std::size_t bytes_{};
+};
+
 class state
 {
    public:
     using payload = cargo::payload;
+
+#ifdef TRICKY_PAYLOAD_ARENA
+    state() noexcept { bind(); }
+    state(const state &) = delete;
+    state &operator=(const state &) = delete;
+    ~state() { payload_.~payload(); }
+
+    void reset() noexcept
+    {
+        type_index_ = 0;
+        on_reset();
+        if (capacity_ != bound_capacity_)
+        {
+            rebind();
+        }
+        else
+        {
+            payload_.reset();
+        }
+    }
+
+    template <typename T>
+    void load(T &&aValue) noexcept
+    {
+        [[maybe_unused]] const std::size_t used = payload_.size();
+        const bool stored = payload_.load(std::forward<T>(aValue));
+        on_load(stored, used, aValue);
+        if (!stored && capacity_ < kMaxCapacity)
+        {
+            // the next error gets a buffer large enough for this value;
+            // capacity_ may be 0 after payload_capacity(0)
+            std::size_t capacity = std::max(capacity_, sizeof(T)) * 2;
+            while (capacity < bound_capacity_ + sizeof(T))
+            {
+                capacity *= 2;
+            }
+            capacity_ = capacity < kMaxCapacity ? capacity : kMaxCapacity;
+        }
+    }
+
+    // Buffer size of the payloads of the next errors. Takes effect at once
+    // when the state holds no error.
+    void payload_capacity(std::size_t aCapacity) noexcept
+    {
+        capacity_ = aCapacity;
+        if (has_value())
+        {
+            rebind();
+        }
+    }
+
+    std::size_t payload_capacity() const noexcept { return capacity_; }
+
+    void payload_upstream(std::pmr::memory_resource *aUpstream) noexcept
+    {
+        enforce_value_state();
+        payload_.~payload();
+        arena_.upstream(aUpstream);
+        bind();
+    }
+
+    const payload_arena &arena() const noexcept { return arena_; }
+#else
     void reset() noexcept
     {
         type_index_ = 0;
+        on_reset();
         payload_.reset();
     }
+
+    template <typename T>
+    void load(T &&aValue) noexcept
+    {
+        [[maybe_unused]] const std::size_t used = payload_.size();
+        const bool stored = payload_.load(std::forward<T>(aValue));
+        on_load(stored, used, aValue);
+    }
+#endif
+
+    payload_stats stats() const noexcept
+    {
+#ifdef TRICKY_PAYLOAD_STATS
+        return counter_.stats();
+#else
+        return {};
+#endif
+    }
+
+    void clear_stats() noexcept
+    {
+#ifdef TRICKY_PAYLOAD_STATS
+        counter_.clear();
+#endif
+    }
     inline constexpr bool has_error() const noexcept { return type_index_; }
     inline constexpr bool has_value() const noexcept { return !has_error(); }
 
@@ -52,25 +229,111 @@ class state
     inline constexpr payload &get_payload() noexcept { return payload_; }
 
    private:
+    // payload values are trivially copyable, so aValue is intact when it
+    // was not stored
+    template <typename T>
+    void on_load([[maybe_unused]] bool aStored,
+                 [[maybe_unused]] std::size_t aUsed,
+                 [[maybe_unused]] const T &aValue) noexcept
+    {
+#ifdef TRICKY_PAYLOAD_STATS
+        counter_.on_load(aStored, aStored ? payload_.size() - aUsed
+                                          : needed_bytes(aValue));
+#endif
+    }
+
+#ifdef TRICKY_PAYLOAD_STATS
+    static constexpr std::size_t kMaxProbe = std::size_t{1} << 20;
+
+    // Bytes a payload would use for aValue, found by loading it into
+    // growing scratch buffers; sizeof(T) if it does not fit in kMaxProbe.
+    template <typename T>
+    static std::size_t needed_bytes(const T &aValue) noexcept
+    {
+        for (std::size_t capacity = std::max(2 * kPayloadMaxSpace, sizeof(T));
+             capacity <= kMaxProbe; capacity *= 2)
+        {
+            std::unique_ptr<char[]> buffer{new (std::nothrow) char[capacity]};
+            if (!buffer)
+            {
+                break;
+            }
+            payload probe{buffer.get(), capacity};
+            if (probe.load(aValue))
+            {
+                return probe.size();
+            }
+        }
+        return sizeof(T);
+    }
+#endif
+
+    void on_reset() noexcept
+    {
+#ifdef TRICKY_PAYLOAD_STATS
+        counter_.on_reset();
+#endif
+    }
+
+#ifdef TRICKY_PAYLOAD_STATS
+    payload_counter counter_;
+#endif
+
+#ifdef TRICKY_PAYLOAD_ARENA
+    static constexpr std::size_t kMaxCapacity = std::size_t{1} << 20;
+
+    // payload_ must not be alive when bind() is called
+    void bind() noexcept
+    {
+        arena_.rewind();
+        auto *buffer = static_cast<char *>(arena_.allocate(capacity_));
+        bound_capacity_ = buffer ? capacity_ : 0;
+        ::new (&payload_) payload(buffer, bound_capacity_);
+    }
+
+    void rebind() noexcept
+    {
+        payload_.~payload();
+        bind();
+    }
+
+    std::size_t type_index_{};
+    std::size_t capacity_{kPayloadMaxSpace};
+    std::size_t bound_capacity_{};
+    payload_arena arena_;
+    union
+    {
+        payload payload_;
+    };
+#else
     std::size_t type_index_{};
     char raw_buf_[kPayloadMaxSpace]{};
     payload payload_{raw_buf_};
+#endif
 };
 
 class shared_state
 {
    public:
     using payload = cargo::payload;
-    static void reset() noexcept { state_.reset(); }
-    static constexpr bool has_error() noexcept { return type_index(); }
-    static constexpr bool has_value() noexcept { return !has_error(); }
 
-    static inline constexpr void enforce_error_state() noexcept
+    // true when every thread owns a separate state (TRICKY_THREAD_LOCAL_STATE)
+    static constexpr bool is_thread_local = kThreadLocalState;
+
+    // true when the state in use can be replaced with activate()
+    // (TRICKY_COROUTINES)
+    static constexpr bool is_switchable = kSwitchableState;
+
+    static void reset() noexcept { current().reset(); }
+    static bool has_error() noexcept { return type_index(); }
+    static bool has_value() noexcept { return !has_error(); }
+
+    static inline void enforce_error_state() noexcept
     {
         assert(has_error() && "state must contain an error.");
     }
 
-    static inline constexpr void enforce_value_state() noexcept
+    static inline void enforce_value_state() noexcept
     {
         assert(has_value() &&
                "state must be clear. It looks like you are trying to "
@@ -80,35 +343,94 @@ class shared_state
 
     static void type_index(std::size_t aIndex) noexcept
     {
-        state_.type_index(aIndex);
+        current().type_index(aIndex);
     }
 
-    static constexpr std::size_t type_index() noexcept
+    static std::size_t type_index() noexcept
     {
-        return state_.type_index();
+        return current().type_index();
     }
 
-    static constexpr const payload &get_const_payload() noexcept
+    static const payload &get_const_payload() noexcept
     {
-        return state_.get_payload();
+        return current().get_payload();
     }
 
-    static constexpr payload &get_payload() noexcept
+    static payload &get_payload() noexcept
     {
-        return state_.get_payload();
+        return current().get_payload();
     }
 
     template <typename T>
     static void load(T &&aValue) noexcept
     {
-        state_.get_payload().load(std::forward<T>(aValue));
+        current().load(std::forward<T>(aValue));
+    }
+
+    // Cheap copy of the payload statistics of the current state. Per thread
+    // with TRICKY_THREAD_LOCAL_STATE.
+    static payload_stats get_payload_stats() noexcept
+    {
+        return current().stats();
+    }
+
+    static void clear_payload_stats() noexcept { current().clear_stats(); }
+
+#ifdef TRICKY_PAYLOAD_ARENA
+    // Payload buffer size of the next errors of the current state. Payloads
+    // which do not fit grow it automatically.
+    static void payload_capacity(std::size_t aCapacity) noexcept
+    {
+        current().payload_capacity(aCapacity);
+    }
+
+    static std::size_t payload_capacity() noexcept
+    {
+        return current().payload_capacity();
+    }
+
+    // Takes payload memory of the current state from aUpstream, for example
+    // a pool owned by the application. Must be called without an error.
+    static void payload_upstream(std::pmr::memory_resource *aUpstream) noexcept
+    {
+        current().payload_upstream(aUpstream);
+    }
+#endif
+
+#ifdef TRICKY_COROUTINES
+    // Makes aState the state of the calling thread (nullptr selects the
+    // thread's own one) and returns the previously active state.
+    static state *activate(state *aState) noexcept
+    {
+        return std::exchange(current_, aState);
     }
 
+    static state *active() noexcept { return &current(); }
+#endif
+
    private:
-    static state state_;
-};
+#ifdef TRICKY_COROUTINES
+    static state &current() noexcept { return current_ ? *current_ : state_; }
+#else
+    static state &current() noexcept { return state_; }
+#endif
 
-state shared_state::state_{};
+#ifdef TRICKY_STATE_DSO
+    // defined in the library built by tricky_add_state_library()
+#ifdef TRICKY_COROUTINES
+    TRICKY_STATE_API thread_local static state *current_;
+#endif
+    TRICKY_STATE_API TRICKY_STATE_STORAGE static state state_;
+#else
+    // one instance per process (per thread with TRICKY_THREAD_LOCAL_STATE)
+    // however many translation units include this header
+#ifdef TRICKY_COROUTINES
+    // always per thread: every thread resumes its own coroutines
+    thread_local static inline state *current_{nullptr};
+#endif
+    TRICKY_STATE_STORAGE static inline state state_{};
+#endif
+};
 }  // namespace details
 
 using shared_state = details::shared_state;
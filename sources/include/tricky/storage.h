@@ -0,0 +1,739 @@
+#ifndef tricky_storage_h
+#define tricky_storage_h
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "state.h"
+
+namespace tricky
+{
+namespace details
+{
+struct shared_layout;
+struct inline_layout;
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+inline constexpr bool kIsLittleEndian =
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#elif defined(_WIN32) || defined(_MSC_VER)
+inline constexpr bool kIsLittleEndian = true;
+#else
+inline constexpr bool kIsLittleEndian = false;
+#endif
+}  // namespace details
+
+template <typename Layout, typename T, typename Error, typename... Errors>
+class basic_result;
+
+template <typename T, typename Error, typename... Errors>
+using result = basic_result<details::shared_layout, T, Error, Errors...>;
+
+template <typename T, typename Error, typename... Errors>
+using inline_result = basic_result<details::inline_layout, T, Error, Errors...>;
+
+template <typename T>
+struct is_result : std::false_type
+{
+};
+
+template <typename Layout, typename T, typename Error, typename... Errors>
+struct is_result<basic_result<Layout, T, Error, Errors...>> : std::true_type
+{
+};
+
+template <typename T>
+inline constexpr bool is_result_v = is_result<T>::value;
+
+// Tells whether the lowest bit of the first byte of every T value (including
+// a value-initialized one) is always 0. inline_result<T, ...> then keeps its
+// type index in that byte and the errors in the rest of T, so it is exactly
+// as large as T. Specialise it for your own types that guarantee this.
+template <typename T, typename = void>
+struct niche_traits : std::false_type
+{
+};
+
+template <typename T>
+struct niche_traits<T *, std::enable_if_t<std::is_object_v<T>>>
+    : std::bool_constant<details::kIsLittleEndian && (alignof(T) > 1)>
+{
+};
+
+template <typename T>
+inline constexpr bool niche_traits_v = niche_traits<T>::value;
+
+namespace details
+{
+template <class T>
+struct stored
+{
+    using type = T;
+    using value_type = T;
+    using value_type_const = T const;
+    using value_cref = T const &;
+    using value_ref = T &;
+    using value_rv_cref = T const &&;
+    using value_rv_ref = T &&;
+};
+
+struct void_
+{
+};
+
+template <typename AnyE, typename Action, typename Indices>
+struct dispatch_table;
+
+// One entry per error type of AnyE, each calling Action with that error. The
+// table is a static constant, so nothing is built at the call site.
+template <typename AnyE, typename Action, std::size_t... I>
+struct dispatch_table<AnyE, Action, std::index_sequence<I...>>
+{
+    using return_type = decltype(std::declval<Action &>()(
+        std::declval<const AnyE &>().template get<0>()));
+    using call_t = return_type (*)(const AnyE &, Action &) noexcept;
+
+    template <std::size_t J>
+    static constexpr return_type call(const AnyE &aErrors,
+                                      Action &aAction) noexcept
+    {
+        return aAction(aErrors.template get<J>());
+    }
+
+    static constexpr call_t kCalls[] = {&call<I>...};
+};
+
+template <typename E, typename... Es>
+union any_error
+{
+    E value;
+    any_error<Es...> rest_values;
+
+    template <typename T, typename Error, typename... Errors>
+    inline constexpr result<T, Error, Errors...> make_result(
+        std::size_t aIndex) const noexcept
+    {
+        return perform(aIndex,
+                       [](auto aError) noexcept
+                       { return result<T, Error, Errors...>{aError}; });
+    }
+
+    // Calls aAction with the error at aIndex through a table of
+    // sizeof...(Es) + 1 entries, so the cost does not depend on the number of
+    // error types.
+    template <typename Action>
+    constexpr decltype(auto) perform(std::size_t aIndex,
+                                     Action &&aAction) const noexcept
+    {
+        assert((aIndex <= sizeof...(Es)) && "invalid index");
+        using table =
+            dispatch_table<any_error, std::remove_reference_t<Action>,
+                           std::make_index_sequence<sizeof...(Es) + 1>>;
+        return table::kCalls[aIndex](*this, aAction);
+    }
+
+    template <std::size_t I>
+    inline constexpr const auto &get() const noexcept
+    {
+        if constexpr (I)
+        {
+            return rest_values.template get<I - 1>();
+        }
+        else
+        {
+            return value;
+        }
+    }
+
+    inline constexpr any_error() noexcept : value() {}
+
+    inline constexpr any_error(const any_error &) = default;
+    inline constexpr any_error &operator=(const any_error &) noexcept = default;
+
+    inline constexpr any_error &operator=(any_error &&) noexcept = default;
+    inline constexpr any_error(any_error &&) noexcept = default;
+
+    template <typename Error>
+    inline constexpr any_error(Error aValue) noexcept
+        : any_error(
+              [aValue]
+              {
+                  if constexpr (std::is_same_v<Error, E>)
+                  {
+                      return E{aValue};
+                  }
+                  else
+                  {
+                      return any_error<Es...>{aValue};
+                  }
+              }(),
+              void_{})
+    {
+    }
+
+   private:
+    inline constexpr any_error(E aValue, void_) noexcept : value(aValue) {}
+
+    inline constexpr any_error(any_error<Es...> aRestValues, void_) noexcept
+        : rest_values(aRestValues)
+    {
+    }
+};
+
+template <typename E>
+union any_error<E>
+{
+    E value;
+
+    template <typename T, typename Error, typename... Errors>
+    inline constexpr result<T, Error, Errors...> make_result(
+        [[maybe_unused]] std::size_t aIndex) const noexcept
+    {
+        return result<T, Error, Errors...>{value};
+    }
+
+    template <typename Action>
+    constexpr decltype(auto) perform([[maybe_unused]] std::size_t aIndex,
+                                     Action &&aAction) const noexcept
+    {
+        assert((aIndex == 0) && "invalid index");
+        return aAction(value);
+    }
+
+    template <std::size_t I>
+    inline constexpr const E &get() const noexcept
+    {
+        static_assert(I == 0, "invalid index");
+        return value;
+    }
+
+    inline constexpr any_error() noexcept : value() {}
+
+    inline constexpr any_error(const any_error &) = default;
+    inline constexpr any_error &operator=(const any_error &) noexcept = default;
+
+    inline constexpr any_error &operator=(any_error &&) noexcept = default;
+    inline constexpr any_error(any_error &&) noexcept = default;
+
+    inline constexpr any_error(E aValue) noexcept : value(aValue) {}
+};
+
+struct error_tag
+{
+};
+
+// The active type index of every result<...> lives in shared_state. The object
+// itself holds nothing but the value or the error.
+struct shared_layout
+{
+};
+
+// The active type index lives inside the object, next to the value. Such
+// results are independent of each other and of shared_state, so they can be
+// stored, kept in containers and passed between threads. They carry no
+// payload; the only value they accept with an error is an e_source_location
+// (TRICKY_NEW_ERROR), which goes to error_telemetry. If T has a niche (see
+// niche_traits) the index shares space with T instead.
+struct inline_layout
+{
+};
+
+template <typename Layout, typename T, typename IndexT, typename... Errors>
+class result_storage;
+
+template <typename T, typename IndexT, typename... Errors>
+class result_storage<shared_layout, T, IndexT, Errors...>
+{
+   public:
+    static inline bool has_error() noexcept
+    {
+        return shared_state::has_error();
+    }
+
+    static inline bool has_value() noexcept
+    {
+        return shared_state::has_value();
+    }
+
+    static inline std::size_t type_index() noexcept
+    {
+        return shared_state::type_index();
+    }
+
+   protected:
+    ~result_storage() = default;
+    inline result_storage() noexcept {}
+
+    template <typename... Args>
+    inline constexpr explicit result_storage(std::in_place_t,
+                                             Args &&...aArgs) noexcept
+        : value_(std::forward<Args>(aArgs)...)
+    {
+    }
+
+    template <typename E>
+    inline result_storage(error_tag, E aError, std::size_t aIndex) noexcept
+        : error_(aError)
+    {
+        shared_state::enforce_value_state();
+        shared_state::type_index(aIndex);
+    }
+
+    inline constexpr result_storage(const result_storage &aOther) noexcept
+        : value_(aOther.value_)
+    {
+        shared_state::enforce_value_state();
+    }
+
+    inline constexpr result_storage &operator=(
+        const result_storage &aOther) noexcept
+    {
+        shared_state::enforce_value_state();
+        if (this != &aOther)
+        {
+            value_ = aOther.value_;
+        }
+        return *this;
+    }
+
+    inline constexpr result_storage(result_storage &&) noexcept = default;
+    inline constexpr result_storage &operator=(result_storage &&) noexcept =
+        default;
+
+    static inline void enforce_error_state() noexcept
+    {
+        shared_state::enforce_error_state();
+    }
+
+    static inline void enforce_value_state() noexcept
+    {
+        shared_state::enforce_value_state();
+    }
+
+    static inline void set_type_index(std::size_t aIndex) noexcept
+    {
+        shared_state::type_index(aIndex);
+    }
+
+    template <typename... Args>
+    inline void construct_value(Args &&...aArgs) noexcept
+    {
+        ::new (static_cast<void *>(std::addressof(value_)))
+            T(std::forward<Args>(aArgs)...);
+    }
+
+    inline constexpr const any_error<Errors...> &errors() const noexcept
+    {
+        return error_;
+    }
+
+    inline constexpr any_error<Errors...> &errors() noexcept { return error_; }
+
+    union
+    {
+        T value_;
+        any_error<Errors...> error_;
+    };
+};
+
+template <typename T, typename IndexT, typename... Errors>
+class result_storage<inline_layout, T, IndexT, Errors...>
+{
+   public:
+    inline constexpr bool has_error() const noexcept { return index_; }
+
+    inline constexpr bool has_value() const noexcept { return !has_error(); }
+
+    inline constexpr std::size_t type_index() const noexcept { return index_; }
+
+   protected:
+    ~result_storage() = default;
+    inline result_storage() noexcept {}
+
+    template <typename... Args>
+    inline constexpr explicit result_storage(std::in_place_t,
+                                             Args &&...aArgs) noexcept
+        : value_(std::forward<Args>(aArgs)...)
+    {
+    }
+
+    template <typename E>
+    inline constexpr result_storage(error_tag, E aError,
+                                    std::size_t aIndex) noexcept
+        : error_(aError), index_(static_cast<IndexT>(aIndex))
+    {
+    }
+
+    inline constexpr result_storage(const result_storage &) noexcept = default;
+    inline constexpr result_storage &operator=(
+        const result_storage &) noexcept = default;
+    inline constexpr result_storage(result_storage &&) noexcept = default;
+    inline constexpr result_storage &operator=(result_storage &&) noexcept =
+        default;
+
+    inline constexpr void enforce_error_state() const noexcept
+    {
+        assert(has_error() && "result must contain an error.");
+    }
+
+    inline constexpr void enforce_value_state() const noexcept
+    {
+        assert(has_value() && "result must contain a value.");
+    }
+
+    inline constexpr void set_type_index(std::size_t aIndex) noexcept
+    {
+        index_ = static_cast<IndexT>(aIndex);
+    }
+
+    template <typename... Args>
+    inline void construct_value(Args &&...aArgs) noexcept
+    {
+        ::new (static_cast<void *>(std::addressof(value_)))
+            T(std::forward<Args>(aArgs)...);
+        index_ = 0;
+    }
+
+    inline constexpr const any_error<Errors...> &errors() const noexcept
+    {
+        return error_;
+    }
+
+    inline constexpr any_error<Errors...> &errors() noexcept { return error_; }
+
+    union
+    {
+        T value_;
+        any_error<Errors...> error_;
+    };
+    IndexT index_{};
+};
+
+template <typename... Errors>
+struct niche_error
+{
+    std::uint8_t tag_;
+    any_error<Errors...> error_;
+};
+
+template <typename T, typename... Errors>
+struct can_use_niche
+    : std::conjunction<niche_traits<T>, std::is_trivially_copyable<T>,
+                       std::bool_constant<(sizeof...(Errors) < 127)>,
+                       std::bool_constant<(sizeof(niche_error<Errors...>) <=
+                                           sizeof(T))>,
+                       std::bool_constant<(alignof(niche_error<Errors...>) <=
+                                           alignof(T))>>
+{
+};
+
+template <typename T, typename... Errors>
+inline constexpr bool can_use_niche_v = can_use_niche<T, Errors...>::value;
+
+// inline_layout for T with a niche (see niche_traits): the lowest bit of the
+// first byte tells value from error, the remaining bits of that byte hold
+// the type index and the error itself follows it inside T.
+template <typename T, typename... Errors>
+class niche_storage
+{
+   public:
+    inline bool has_error() const noexcept { return tag() & 1u; }
+
+    inline bool has_value() const noexcept { return !has_error(); }
+
+    inline std::size_t type_index() const noexcept
+    {
+        const std::uint8_t kTag = tag();
+        return (kTag & 1u) ? (kTag >> 1) : 0;
+    }
+
+   protected:
+    ~niche_storage() = default;
+    inline constexpr niche_storage() noexcept : value_() {}
+
+    template <typename... Args>
+    inline constexpr explicit niche_storage(std::in_place_t,
+                                            Args &&...aArgs) noexcept
+        : value_(std::forward<Args>(aArgs)...)
+    {
+    }
+
+    template <typename E>
+    inline constexpr niche_storage(error_tag, E aError,
+                                   std::size_t aIndex) noexcept
+        : niche_{static_cast<std::uint8_t>((aIndex << 1) | 1u), aError}
+    {
+    }
+
+    inline constexpr niche_storage(const niche_storage &) noexcept = default;
+    inline constexpr niche_storage &operator=(const niche_storage &) noexcept =
+        default;
+    inline constexpr niche_storage(niche_storage &&) noexcept = default;
+    inline constexpr niche_storage &operator=(niche_storage &&) noexcept =
+        default;
+
+    inline void enforce_error_state() const noexcept
+    {
+        assert(has_error() && "result must contain an error.");
+    }
+
+    inline void enforce_value_state() const noexcept
+    {
+        assert(has_value() && "result must contain a value.");
+    }
+
+    inline void set_type_index(std::size_t aIndex) noexcept
+    {
+        const auto kTag =
+            static_cast<std::uint8_t>(aIndex ? ((aIndex << 1) | 1u) : 0u);
+        std::memcpy(&niche_.tag_, &kTag, sizeof(kTag));
+    }
+
+    template <typename... Args>
+    inline void construct_value(Args &&...aArgs) noexcept
+    {
+        ::new (static_cast<void *>(std::addressof(value_)))
+            T(std::forward<Args>(aArgs)...);
+    }
+
+    inline const any_error<Errors...> &errors() const noexcept
+    {
+        return niche_.error_;
+    }
+
+    inline any_error<Errors...> &errors() noexcept { return niche_.error_; }
+
+    union
+    {
+        T value_;
+        niche_error<Errors...> niche_;
+    };
+
+   private:
+    inline std::uint8_t tag() const noexcept
+    {
+        std::uint8_t tag;
+        std::memcpy(&tag, &niche_.tag_, sizeof(tag));
+        return tag;
+    }
+};
+
+template <bool kCopyable>
+struct copy_guard
+{
+};
+
+template <>
+struct copy_guard<false>
+{
+    copy_guard() = default;
+    copy_guard(const copy_guard &) = delete;
+    copy_guard &operator=(const copy_guard &) = delete;
+    copy_guard(copy_guard &&) = default;
+    copy_guard &operator=(copy_guard &&) = default;
+};
+
+// Storage for T that is not trivially copyable (std::vector, std::unique_ptr,
+// ...). The type index is kept in the object whatever the layout is, so that
+// copies, moves and the destructor touch the active member only. Results of
+// shared_layout also publish the index to shared_state, as usual.
+template <typename Layout, typename T, typename IndexT, typename... Errors>
+class nontrivial_storage_base
+{
+    static constexpr bool kIsShared = std::is_same_v<Layout, shared_layout>;
+
+   public:
+    inline constexpr bool has_error() const noexcept { return index_; }
+
+    inline constexpr bool has_value() const noexcept { return !has_error(); }
+
+    inline constexpr std::size_t type_index() const noexcept { return index_; }
+
+   protected:
+    ~nontrivial_storage_base() { destroy_value(); }
+
+    // leaves the object without an active member, the caller constructs one
+    inline nontrivial_storage_base() noexcept {}
+
+    template <typename... Args>
+    inline explicit nontrivial_storage_base(std::in_place_t,
+                                            Args &&...aArgs) noexcept(
+        std::is_nothrow_constructible_v<T, Args &&...>)
+        : value_(std::forward<Args>(aArgs)...)
+    {
+    }
+
+    template <typename E>
+    inline nontrivial_storage_base(error_tag, E aError,
+                                   std::size_t aIndex) noexcept
+        : error_(aError), index_(static_cast<IndexT>(aIndex))
+    {
+        if constexpr (kIsShared)
+        {
+            shared_state::enforce_value_state();
+            shared_state::type_index(aIndex);
+        }
+    }
+
+    inline nontrivial_storage_base(
+        const nontrivial_storage_base
+            &aOther) noexcept(std::is_nothrow_copy_constructible_v<T>)
+        : index_(aOther.index_)
+    {
+        if (aOther.has_value())
+        {
+            construct_value(aOther.value_);
+        }
+        else
+        {
+            error_ = aOther.error_;
+        }
+    }
+
+    inline nontrivial_storage_base(nontrivial_storage_base &&aOther) noexcept(
+        std::is_nothrow_move_constructible_v<T>)
+        : index_(aOther.index_)
+    {
+        if (aOther.has_value())
+        {
+            construct_value(std::move(aOther.value_));
+        }
+        else
+        {
+            error_ = aOther.error_;
+        }
+    }
+
+    inline nontrivial_storage_base &operator=(
+        const nontrivial_storage_base &aOther) noexcept(
+        std::is_nothrow_copy_constructible_v<T>
+            && std::is_nothrow_copy_assignable_v<T>)
+    {
+        if (this != &aOther)
+        {
+            assign(aOther);
+        }
+        return *this;
+    }
+
+    inline nontrivial_storage_base &operator=(
+        nontrivial_storage_base &&aOther) noexcept(
+        std::is_nothrow_move_constructible_v<T>
+            && std::is_nothrow_move_assignable_v<T>)
+    {
+        if (this != &aOther)
+        {
+            assign(std::move(aOther));
+        }
+        return *this;
+    }
+
+    inline constexpr void enforce_error_state() const noexcept
+    {
+        assert(has_error() && "result must contain an error.");
+    }
+
+    inline constexpr void enforce_value_state() const noexcept
+    {
+        assert(has_value() && "result must contain a value.");
+    }
+
+    inline void set_type_index(std::size_t aIndex) noexcept
+    {
+        index_ = static_cast<IndexT>(aIndex);
+        if constexpr (kIsShared)
+        {
+            shared_state::type_index(aIndex);
+        }
+    }
+
+    template <typename... Args>
+    inline void construct_value(Args &&...aArgs) noexcept(
+        std::is_nothrow_constructible_v<T, Args &&...>)
+    {
+        ::new (static_cast<void *>(std::addressof(value_)))
+            T(std::forward<Args>(aArgs)...);
+        index_ = 0;
+    }
+
+    inline constexpr const any_error<Errors...> &errors() const noexcept
+    {
+        return error_;
+    }
+
+    inline constexpr any_error<Errors...> &errors() noexcept { return error_; }
+
+    union
+    {
+        T value_;
+        any_error<Errors...> error_;
+    };
+    IndexT index_{};
+
+   private:
+    inline void destroy_value() noexcept
+    {
+        if (has_value())
+        {
+            value_.~T();
+        }
+    }
+
+    template <typename Other>
+    inline void assign(Other &&aOther)
+    {
+        if (aOther.has_value())
+        {
+            if (has_value())
+            {
+                value_ = std::forward<Other>(aOther).value_;
+            }
+            else
+            {
+                construct_value(std::forward<Other>(aOther).value_);
+            }
+        }
+        else
+        {
+            destroy_value();
+            error_ = aOther.error_;
+            index_ = aOther.index_;
+        }
+    }
+};
+
+template <typename Layout, typename T, typename IndexT, typename... Errors>
+class nontrivial_storage
+    : public nontrivial_storage_base<Layout, T, IndexT, Errors...>,
+      private copy_guard<std::is_copy_constructible_v<T>>
+{
+    using base = nontrivial_storage_base<Layout, T, IndexT, Errors...>;
+
+   protected:
+    using base::base;
+    ~nontrivial_storage() = default;
+    nontrivial_storage() = default;
+    nontrivial_storage(const nontrivial_storage &) = default;
+    nontrivial_storage(nontrivial_storage &&) = default;
+    nontrivial_storage &operator=(const nontrivial_storage &) = default;
+    nontrivial_storage &operator=(nontrivial_storage &&) = default;
+};
+
+template <typename Layout, typename T, typename IndexT, typename... Errors>
+using storage_t = std::conditional_t<
+    std::is_trivially_copyable_v<T>,
+    std::conditional_t<
+        std::conjunction_v<std::is_same<Layout, inline_layout>,
+                           can_use_niche<T, Errors...>>,
+        niche_storage<T, Errors...>,
+        result_storage<Layout, T, IndexT, Errors...>>,
+    nontrivial_storage<Layout, T, IndexT, Errors...>>;
+}  // namespace details
+}  // namespace tricky
+
+#endif /* tricky_storage_h */
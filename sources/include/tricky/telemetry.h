@@ -0,0 +1,342 @@
+#ifndef tricky_telemetry_h
+#define tricky_telemetry_h
+
+#include <type_name/type_name.h>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <type_traits>
+
+#include "data.h"
+
+namespace tricky
+{
+#ifdef TRICKY_ERROR_TELEMETRY
+inline constexpr bool kErrorTelemetry = true;
+#else
+inline constexpr bool kErrorTelemetry = false;
+#endif
+
+#ifdef TRICKY_ERROR_TELEMETRY_CAPACITY
+inline constexpr std::size_t kErrorTelemetryCapacity =
+    TRICKY_ERROR_TELEMETRY_CAPACITY;
+#else
+inline constexpr std::size_t kErrorTelemetryCapacity = 64;
+#endif
+
+static_assert(kErrorTelemetryCapacity > 0 &&
+                  (kErrorTelemetryCapacity & (kErrorTelemetryCapacity - 1)) ==
+                      0,
+              "TRICKY_ERROR_TELEMETRY_CAPACITY must be a power of two");
+
+// Error recorded by error_telemetry when a result<...> is built with it.
+struct error_record
+{
+    using clock = std::chrono::steady_clock;
+
+    bool has_location() const noexcept { return file != nullptr; }
+
+    e_source_location location() const noexcept
+    {
+        assert(has_location() && "record has no source location.");
+        return {file, line, function};
+    }
+
+    std::string_view category;
+    std::int64_t value{};
+    char const *file{nullptr};
+    int line{};
+    char const *function{nullptr};
+    clock::time_point time{};
+};
+
+namespace details
+{
+template <typename T>
+constexpr const e_source_location *as_location(const T &aValue) noexcept
+{
+    if constexpr (std::is_same_v<T, e_source_location>)
+    {
+        return &aValue;
+    }
+    else
+    {
+        static_cast<void>(aValue);
+        return nullptr;
+    }
+}
+
+// first e_source_location among the payload values or nullptr
+template <typename... Values>
+constexpr const e_source_location *find_location(
+    const Values &...aValues) noexcept
+{
+    const e_source_location *location = nullptr;
+    (..., (location = location ? location : as_location(aValues)));
+    return location;
+}
+
+// Single producer ring which keeps the last Capacity records. The producer
+// never waits: it overwrites the oldest record and every slot carries a
+// sequence number (seqlock) so that the consumer detects records which were
+// overwritten while it copied them.
+template <std::size_t Capacity>
+class error_ring
+{
+   public:
+    void push(std::string_view aCategory, std::int64_t aValue,
+              const e_source_location *aLocation,
+              error_record::clock::time_point aTime) noexcept
+    {
+        const std::uint64_t index = head_.load(std::memory_order_relaxed);
+        slot &s = slots_[index & kMask];
+        s.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s.category.store(aCategory.data(), std::memory_order_relaxed);
+        s.category_size.store(aCategory.size(), std::memory_order_relaxed);
+        s.value.store(aValue, std::memory_order_relaxed);
+        s.file.store(aLocation ? aLocation->file() : nullptr,
+                     std::memory_order_relaxed);
+        s.line.store(aLocation ? aLocation->line() : 0,
+                     std::memory_order_relaxed);
+        s.function.store(aLocation ? aLocation->function() : nullptr,
+                         std::memory_order_relaxed);
+        s.time.store(aTime.time_since_epoch().count(),
+                     std::memory_order_relaxed);
+        s.sequence.store(2 * index + 2, std::memory_order_release);
+        head_.store(index + 1, std::memory_order_release);
+    }
+
+    // Returns false when another consumer is draining this ring.
+    template <typename Callback>
+    bool drain(Callback &aCallback, std::size_t &aCount) noexcept
+    {
+        if (draining_.exchange(true, std::memory_order_acquire))
+        {
+            return false;
+        }
+        const std::uint64_t head = head_.load(std::memory_order_acquire);
+        if (head - tail_ > Capacity)
+        {
+            lost_.fetch_add(head - tail_ - Capacity,
+                            std::memory_order_relaxed);
+            tail_ = head - Capacity;
+        }
+        for (; tail_ != head; ++tail_)
+        {
+            error_record record;
+            if (read(tail_, record))
+            {
+                aCallback(static_cast<const error_record &>(record));
+                ++aCount;
+            }
+            else
+            {
+                lost_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        draining_.store(false, std::memory_order_release);
+        return true;
+    }
+
+    std::uint64_t lost() const noexcept
+    {
+        return lost_.load(std::memory_order_relaxed);
+    }
+
+    bool try_own() noexcept
+    {
+        return !owned_.exchange(true, std::memory_order_acquire);
+    }
+
+    void disown() noexcept { owned_.store(false, std::memory_order_release); }
+
+    error_ring *next_{nullptr};
+
+   private:
+    static constexpr std::uint64_t kMask = Capacity - 1;
+
+    struct slot
+    {
+        std::atomic<std::uint64_t> sequence{};
+        std::atomic<char const *> category{};
+        std::atomic<std::size_t> category_size{};
+        std::atomic<std::int64_t> value{};
+        std::atomic<char const *> file{};
+        std::atomic<int> line{};
+        std::atomic<char const *> function{};
+        std::atomic<error_record::clock::rep> time{};
+    };
+
+    bool read(std::uint64_t aIndex, error_record &aRecord) const noexcept
+    {
+        const slot &s = slots_[aIndex & kMask];
+        const std::uint64_t sequence =
+            s.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * aIndex + 2)
+        {
+            return false;
+        }
+        aRecord.category = {s.category.load(std::memory_order_relaxed),
+                            s.category_size.load(std::memory_order_relaxed)};
+        aRecord.value = s.value.load(std::memory_order_relaxed);
+        aRecord.file = s.file.load(std::memory_order_relaxed);
+        aRecord.line = s.line.load(std::memory_order_relaxed);
+        aRecord.function = s.function.load(std::memory_order_relaxed);
+        aRecord.time = error_record::clock::time_point(
+            error_record::clock::duration(
+                s.time.load(std::memory_order_relaxed)));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return s.sequence.load(std::memory_order_relaxed) == sequence;
+    }
+
+    std::atomic<std::uint64_t> head_{};
+    std::uint64_t tail_{};
+    std::atomic<std::uint64_t> lost_{};
+    std::atomic<bool> draining_{};
+    std::atomic<bool> owned_{};
+    slot slots_[Capacity];
+};
+}  // namespace details
+
+// Keeps the last kErrorTelemetryCapacity errors of every thread when
+// TRICKY_ERROR_TELEMETRY is defined. Producers never block; a collector
+// drains the records of all threads, including the ones that already exited.
+class error_telemetry
+{
+   public:
+    using ring = details::error_ring<kErrorTelemetryCapacity>;
+
+    static constexpr bool enabled = kErrorTelemetry;
+    static constexpr std::size_t capacity = kErrorTelemetryCapacity;
+
+    template <typename E>
+    static void record(E aError, const e_source_location *aLocation) noexcept
+    {
+        static_assert(std::is_enum_v<E>);
+        if constexpr (enabled)
+        {
+            ring *r = local();
+            if (!r)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            using underlying_t = std::underlying_type_t<E>;
+            const auto value =
+                static_cast<std::int64_t>(static_cast<underlying_t>(aError));
+            r->push(type_name::kName<E>, value, aLocation,
+                    error_record::clock::now());
+        }
+        else
+        {
+            static_cast<void>(aError);
+            static_cast<void>(aLocation);
+        }
+    }
+
+    // Calls aCallback(const error_record &) for every record which was not
+    // drained yet, oldest first within a thread. Returns the number of
+    // records passed to aCallback.
+    template <typename Callback>
+    static std::size_t drain(Callback &&aCallback) noexcept
+    {
+        std::size_t count = 0;
+        if constexpr (enabled)
+        {
+            for (ring *r = rings_.load(std::memory_order_acquire); r;
+                 r = r->next_)
+            {
+                r->drain(aCallback, count);
+            }
+        }
+        return count;
+    }
+
+    // number of records overwritten before they were drained or dropped
+    // because the thread had no ring
+    static std::uint64_t lost() noexcept
+    {
+        std::uint64_t count = dropped_.load(std::memory_order_relaxed);
+        for (ring *r = rings_.load(std::memory_order_acquire); r; r = r->next_)
+        {
+            count += r->lost();
+        }
+        return count;
+    }
+
+   private:
+    class owner
+    {
+       public:
+        owner() noexcept : ring_(acquire()) { local_ = ring_; }
+        ~owner()
+        {
+            local_ = nullptr;
+            exited_ = true;
+            if (ring_)
+            {
+                ring_->disown();
+            }
+        }
+        owner(const owner &) = delete;
+        owner &operator=(const owner &) = delete;
+
+       private:
+        ring *ring_;
+    };
+
+    // nullptr once the thread is exiting and its ring was handed over, e.g.
+    // for errors raised by later thread_local destructors
+    static ring *local() noexcept
+    {
+        if (!local_ && !exited_)
+        {
+            thread_local owner o;
+        }
+        return local_;
+    }
+
+    // Rings are never freed: a ring released by an exited thread keeps its
+    // records for the collector and is reused by the next new thread.
+    static ring *acquire() noexcept
+    {
+        ring *head = rings_.load(std::memory_order_acquire);
+        for (ring *r = head; r; r = r->next_)
+        {
+            if (r->try_own())
+            {
+                return r;
+            }
+        }
+        ring *r = new (std::nothrow) ring;
+        if (!r)
+        {
+            return nullptr;
+        }
+        r->try_own();
+        r->next_ = head;
+        while (!rings_.compare_exchange_weak(r->next_, r,
+                                             std::memory_order_release,
+                                             std::memory_order_acquire))
+        {
+        }
+        return r;
+    }
+
+    // Trivially destructible, so they stay readable during the whole thread
+    // exit, unlike the owner which disowns the ring of the thread.
+    static inline thread_local ring *local_{nullptr};
+    static inline thread_local bool exited_{};
+
+    static inline std::atomic<ring *> rings_{nullptr};
+    static inline std::atomic<std::uint64_t> dropped_{};
+};
+}  // namespace tricky
+
+#endif /* tricky_telemetry_h */
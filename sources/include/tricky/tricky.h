@@ -12,6 +12,8 @@
 #include "handlers.h"
 #include "lazy_load.h"
 #include "state.h"
+#include "storage.h"
+#include "telemetry.h"
 
 #define TRICKY_SOURCE_LOCATION \
     ::tricky::e_source_location { __FILE__, __LINE__, __FUNCTION__ }
@@ -29,162 +31,47 @@
     auto &&TRICKY_TMP = r;                                                    \
     static_assert(tricky::is_result_v<std::decay_t<decltype(TRICKY_TMP)>>,    \
                   "second argument must be tricky::result<>. See is_result"); \
-    if (!TRICKY_TMP) return TRICKY_TMP;                                       \
+    if (!TRICKY_TMP) return std::forward<decltype(TRICKY_TMP)>(TRICKY_TMP);   \
     v = std::forward<decltype(TRICKY_TMP)>(TRICKY_TMP).value()
 
 #define TRICKY_AUTO(v, r) TRICKY_ASSIGN(auto v, r)
 
 namespace tricky
 {
-namespace details
-{
-template <class T>
-struct stored
-{
-    using type = T;
-    using value_type = T;
-    using value_type_const = T const;
-    using value_cref = T const &;
-    using value_ref = T &;
-    using value_rv_cref = T const &&;
-    using value_rv_ref = T &&;
-};
-
-struct void_
-{
-};
-
-template <typename E, typename... Es>
-union any_error
-{
-    E value;
-    any_error<Es...> rest_values;
-
-    template <typename T, typename Error, typename... Errors>
-    inline constexpr result<T, Error, Errors...> make_result(
-        [[maybe_unused]] std::size_t aIndex) const noexcept
-    {
-        if (aIndex)
-        {
-            return rest_values.template make_result<T, Error, Errors...>(
-                aIndex - 1);
-        }
-        else
-        {
-            return result<T, Error, Errors...>{value};
-        }
-    }
-
-    template <typename Action>
-    constexpr void perform(std::size_t aIndex, Action &&aAction) const noexcept
-    {
-        if (aIndex)
-        {
-            rest_values.perform(aIndex - 1, std::forward<Action>(aAction));
-        }
-        else
-        {
-            aAction(value);
-        }
-    }
-
-    inline constexpr any_error() noexcept : value() {}
-
-    inline constexpr any_error(const any_error &) = default;
-    inline constexpr any_error &operator=(const any_error &) noexcept = default;
-
-    inline constexpr any_error &operator=(any_error &&) noexcept = default;
-    inline constexpr any_error(any_error &&) noexcept = default;
-
-    template <typename Error>
-    inline constexpr any_error(Error aValue) noexcept
-        : any_error(
-              [aValue]
-              {
-                  if constexpr (std::is_same_v<Error, E>)
-                  {
-                      return E{aValue};
-                  }
-                  else
-                  {
-                      return any_error<Es...>{aValue};
-                  }
-              }(),
-              void_{})
-    {
-    }
-
-   private:
-    inline constexpr any_error(E aValue, void_) noexcept : value(aValue) {}
-
-    inline constexpr any_error(any_error<Es...> aRestValues, void_) noexcept
-        : rest_values(aRestValues)
-    {
-    }
-};
-
-template <typename E>
-union any_error<E>
-{
-    E value;
-
-    template <typename T, typename Error, typename... Errors>
-    inline constexpr result<T, Error, Errors...> make_result(
-        [[maybe_unused]] std::size_t aIndex) const noexcept
-    {
-        return result<T, Error, Errors...>{value};
-    }
-
-    template <typename Action>
-    constexpr void perform([[maybe_unused]] std::size_t aIndex,
-                           Action &&aAction) const noexcept
-    {
-        assert((aIndex == 0) && "invalid index");
-        aAction(value);
-    }
-
-    inline constexpr any_error() noexcept : value() {}
-
-    inline constexpr any_error(const any_error &) = default;
-    inline constexpr any_error &operator=(const any_error &) noexcept = default;
-
-    inline constexpr any_error &operator=(any_error &&) noexcept = default;
-    inline constexpr any_error(any_error &&) noexcept = default;
-
-    inline constexpr any_error(E aValue) noexcept : value(aValue) {}
-};
-
-enum class eDiscriminant
-{
-    kSuccess,
-    kError,
-    kInvalid
-};
-}  // namespace details
-
-template <typename T, typename Error, typename... Errors>
-class result
+template <typename Layout, typename T, typename Error, typename... Errors>
+class basic_result
+    : public details::storage_t<
+          Layout, typename details::stored<T>::type,
+          utils::uint_from_nbits_t<utils::bits_count(sizeof...(Errors) + 2_uz)>,
+          Error, Errors...>
 {
    private:
-    template <typename U, typename E, typename... Es>
-    friend class result;
+    template <typename L, typename U, typename E, typename... Es>
+    friend class basic_result;
 
     template <typename... Handlers>
     friend class details::handlers_base;
 
-    using eDiscriminant = details::eDiscriminant;
-
-    using shared_state = shared_state;
-
     using error_types = utils::type_list<Error, Errors...>;
 
     using all_types = utils::type_list<T, Error, Errors...>;
 
    public:
+    using layout = Layout;
     static constexpr std::size_t type_count = sizeof...(Errors) + 2_uz;
     using index_t = utils::uint_from_nbits_t<utils::bits_count(type_count)>;
 
    private:
+    using storage =
+        details::storage_t<Layout, typename details::stored<T>::type, index_t,
+                           Error, Errors...>;
+
+    // Only results of shared_layout own the shared error state. Inline results
+    // carry no payload, so they never touch shared_state and can be created
+    // and handled while a shared error is pending.
+    static constexpr bool kIsShared =
+        std::is_same_v<Layout, details::shared_layout>;
+
     template <typename U>
     static constexpr std::size_t type_index_v =
         all_types::template first_index_of_type<U>;
@@ -196,7 +83,23 @@ class result
             std::bool_constant<type_index_v<E> != all_types::size>>,
         R>;
 
-    using R = result<T, Error, Errors...>;
+    template <typename U, class R = void>
+    using enable_if_value_t = std::enable_if_t<
+        std::conjunction_v<
+            std::negation<is_result<utils::remove_cvref_t<U>>>,
+            std::negation<std::is_same<utils::remove_cvref_t<U>,
+                                       std::in_place_t>>,
+            std::bool_constant<type_index_v<utils::remove_cvref_t<U>> == 0 ||
+                               type_index_v<utils::remove_cvref_t<U>> ==
+                                   all_types::size>,
+            std::is_convertible<U &&, T>>,
+        R>;
+
+    template <typename R>
+    using enable_if_other_result_t = std::enable_if_t<std::conjunction_v<
+        is_result<utils::remove_cvref_t<R>>,
+        std::negation<std::is_lvalue_reference<R>>,
+        std::negation<std::is_same<utils::remove_cvref_t<R>, basic_result>>>>;
 
     template <typename U>
     using stored_type = typename details::stored<U>::type;
@@ -216,48 +119,85 @@ class result
     template <typename U>
     using value_rv_cref = typename details::stored<U>::value_rv_cref;
 
+    using storage::errors;
+    using storage::set_type_index;
+    using storage::value_;
+
+   protected:
+    using storage::enforce_error_state;
+    using storage::enforce_value_state;
+
    public:
     using value_type = typename details::stored<T>::value_type;
+    using storage::has_error;
+    using storage::has_value;
+    using storage::type_index;
 
-    ~result() = default;
-    inline constexpr result() noexcept : result(T{}) {}
-
-    inline constexpr result(const result &aOther) noexcept
+    ~basic_result() = default;
+    inline constexpr basic_result() noexcept(
+        std::is_nothrow_default_constructible_v<T>)
+        : storage(std::in_place)
     {
-        shared_state::enforce_value_state();
-        value_ = aOther.value_;
     }
 
-    inline constexpr result &operator=(const result &aOther) noexcept
+    inline constexpr basic_result(const basic_result &) = default;
+    inline constexpr basic_result &operator=(const basic_result &) = default;
+    inline constexpr basic_result &operator=(basic_result &&) = default;
+    inline constexpr basic_result(basic_result &&) = default;
+
+    template <typename U = T, enable_if_value_t<U, int> = 0>
+    inline constexpr basic_result(U &&aValue) noexcept(
+        std::is_nothrow_constructible_v<T, U &&>)
+        : storage(std::in_place, std::forward<U>(aValue))
     {
-        shared_state::enforce_value_state();
-        if (this != &aOther)
-        {
-            value_ = aOther.value_;
-        }
-        return *this;
     }
 
-    inline constexpr result &operator=(result &&) noexcept = default;
-    inline constexpr result(result &&) noexcept = default;
-
-    inline constexpr result(T aValue) noexcept : value_(aValue) {}
+    template <typename... Args,
+              typename = std::enable_if_t<std::is_constructible_v<T, Args...>>>
+    inline constexpr explicit basic_result(std::in_place_t,
+                                           Args &&...aArgs) noexcept(
+        std::is_nothrow_constructible_v<T, Args &&...>)
+        : storage(std::in_place, std::forward<Args>(aArgs)...)
+    {
+    }
 
     template <typename E, typename... PayloadValue,
               typename = enable_if_valid_error_t<E>>
-    inline result(E aError, PayloadValue &&...aValue) noexcept : error_(aError)
+    inline basic_result(E aError, PayloadValue &&...aValue) noexcept
+        : storage(details::error_tag{}, aError, type_index_v<E>)
+    {
+        // an inline result takes a source location, for telemetry only
+        static_assert(
+            kIsShared ||
+                (... && std::is_same_v<utils::remove_cvref_t<PayloadValue>,
+                                       e_source_location>),
+            "inline results carry no payload");
+        if constexpr (kErrorTelemetry)
+        {
+            error_telemetry::record(aError, details::find_location(aValue...));
+        }
+        if constexpr (kIsShared)
+        {
+            (..., shared_state::load(std::forward<PayloadValue>(aValue)));
+        }
+    }
+
+    // Rebuilds an error which was already reported, e.g. the one of a lane of
+    // result_batch: neither telemetry nor the payload is touched.
+    template <typename E, typename = enable_if_valid_error_t<E>>
+    inline constexpr basic_result(details::error_tag, E aError) noexcept
+        : storage(details::error_tag{}, aError, type_index_v<E>)
     {
-        shared_state::enforce_value_state();
-        shared_state::type_index(type_index_v<E>);
-        (..., shared_state::load(std::forward<PayloadValue>(aValue)));
     }
 
-    template <typename R,
-              typename = std::enable_if_t<is_result_v<std::decay_t<R>>>>
-    inline result(const R &&aResult) noexcept
+    template <typename R, typename = enable_if_other_result_t<R>>
+    inline basic_result(R &&aResult) noexcept
     {
-        using CoreT = std::decay_t<R>;
+        using CoreT = utils::remove_cvref_t<R>;
         static_assert(is_result_v<CoreT>);
+        static_assert(std::is_same_v<typename CoreT::layout, layout>,
+                      "conversion between results of different layouts is "
+                      "not supported");
         using other_value_type = typename CoreT::value_type;
         constexpr bool is_compatible = std::disjunction_v<
             std::is_same<other_value_type, value_type>,
@@ -267,7 +207,7 @@ class result
         {
             if (aResult.has_value())
             {
-                value_ = aResult.value_;
+                this->construct_value(std::forward<R>(aResult).value_);
             }
             else
             {
@@ -276,47 +216,34 @@ class result
         }
         else
         {
-            shared_state::enforce_error_state();
+            aResult.enforce_error_state();
             init(std::move(aResult));
         }
     }
 
-    explicit operator bool() const noexcept
-    {
-        return shared_state::has_value();
-    }
-
-    static inline bool has_error() noexcept
-    {
-        return shared_state::has_error();
-    }
-
-    static inline bool has_value() noexcept
-    {
-        return shared_state::has_value();
-    }
+    explicit operator bool() const noexcept { return has_value(); }
 
     inline value_cref<T> value() const &noexcept
     {
-        shared_state::enforce_value_state();
+        enforce_value_state();
         return value_;
     }
 
     inline value_ref<T> value() &noexcept
     {
-        shared_state::enforce_value_state();
+        enforce_value_state();
         return value_;
     }
 
     inline value_rv_cref<T> value() const &&noexcept
     {
-        shared_state::enforce_value_state();
+        enforce_value_state();
         return std::move(value_);
     }
 
     inline value_rv_ref<T> value() &&noexcept
     {
-        shared_state::enforce_value_state();
+        enforce_value_state();
         return std::move(value_);
     }
 
@@ -328,12 +255,12 @@ class result
                           std::is_same<value_type, details::void_>>)
         {
             constexpr std::size_t kIndex = type_index_v<value_type>;
-            return kIndex == shared_state::type_index();
+            return kIndex == type_index();
         }
         else
         {
             constexpr std::size_t kIndex = type_index_v<U>;
-            return kIndex == shared_state::type_index();
+            return kIndex == type_index();
         }
     }
 
@@ -341,14 +268,14 @@ class result
     inline value_cref<E> error() const &noexcept
     {
         enforce_error_type<E>();
-        return error_at<E, type_index_v<E> - 1>(error_);
+        return error_at<E, type_index_v<E> - 1>(errors());
     }
 
     template <typename E>
     inline value_ref<E> error() &noexcept
     {
         enforce_error_type<E>();
-        return error_at<E, type_index_v<E> - 1>(error_);
+        return error_at<E, type_index_v<E> - 1>(errors());
     }
 
     template <typename E>
@@ -356,7 +283,7 @@ class result
     {
         enforce_error_type<E>();
         return std::move(*this).template error_at<E, type_index_v<E> - 1>(
-            error_);
+            errors());
     }
 
     template <typename E>
@@ -364,13 +291,14 @@ class result
     {
         enforce_error_type<E>();
         return std::move(*this).template error_at<E, type_index_v<E> - 1>(
-            error_);
+            errors());
     }
 
     template <typename... V>
-    static void load(V &&...aValue) noexcept
+    void load(V &&...aValue) const noexcept
     {
         static_assert(sizeof...(V) > 0);
+        static_assert(kIsShared, "inline results carry no payload");
         if (has_error())
         {
             (..., shared_state::load(std::forward<V>(aValue)));
@@ -384,14 +312,14 @@ class result
         using errors_of_R = typename std::decay_t<R>::error_types;
         static_assert(error_types::template contains_v<errors_of_R>,
                       "errors of type R must be subset of <Error, Errors...>");
-        aResult.error_.perform(
-            shared_state::type_index() - 1,
+        aResult.errors().perform(
+            aResult.type_index() - 1,
             [this](auto aError)
             {
                 using ActiveType = decltype(aError);
-                error_at<ActiveType, type_index_v<ActiveType> - 1>(error_) =
+                error_at<ActiveType, type_index_v<ActiveType> - 1>(errors()) =
                     aError;
-                shared_state::type_index(type_index_v<ActiveType>);
+                set_type_index(type_index_v<ActiveType>);
             });
     }
 
@@ -452,68 +380,67 @@ class result
     template <typename E>
     inline void enforce_error_type() const noexcept
     {
-        shared_state::enforce_error_state();
+        enforce_error_state();
         assert(
             is_active_type<E>() &&
             "type of value stored in this result object is different than E.");
     }
-
-    union
-    {
-        stored_type<T> value_;
-        details::any_error<Error, Errors...> error_;
-    };
-    eDiscriminant what_{eDiscriminant::kSuccess};
 };
 
-template <typename Error, typename... Errors>
-class result<void, Error, Errors...>
-    : public result<details::void_, Error, Errors...>
+template <typename Layout, typename Error, typename... Errors>
+class basic_result<Layout, void, Error, Errors...>
+    : public basic_result<Layout, details::void_, Error, Errors...>
 {
-    template <typename U, typename E, typename... Es>
-    friend class result;
+    template <typename L, typename U, typename E, typename... Es>
+    friend class basic_result;
 
     template <typename... Handlers>
-    friend class handlers_base;
+    friend class details::handlers_base;
 
     using void_ = details::void_;
-    using base = result<void_, Error, Errors...>;
+    using base = basic_result<Layout, void_, Error, Errors...>;
 
    public:
     using base::operator bool;
     using value_type = void;
 
-    ~result() = default;
-    inline constexpr result() noexcept = default;
+    ~basic_result() = default;
+    inline constexpr basic_result() noexcept = default;
 
-    inline constexpr result(const result &aOther) noexcept : base(aOther) {}
+    inline constexpr basic_result(const basic_result &aOther) noexcept
+        : base(aOther)
+    {
+    }
 
-    inline constexpr result(result &&) noexcept = default;
-    inline constexpr result &operator=(const result &aOther) noexcept
+    inline constexpr basic_result(basic_result &&) noexcept = default;
+    inline constexpr basic_result &operator=(
+        const basic_result &aOther) noexcept
     {
         base::operator=(aOther);
         return *this;
     }
 
-    inline constexpr result &operator=(result &&) noexcept = default;
+    inline constexpr basic_result &operator=(basic_result &&) noexcept =
+        default;
 
     template <typename E, typename... PayloadValue,
               typename = std::enable_if_t<std::is_enum_v<E>>>
-    inline result(E aError, PayloadValue &&...aValue) noexcept
+    inline basic_result(E aError, PayloadValue &&...aValue) noexcept
         : base(aError, std::forward<PayloadValue>(aValue)...)
     {
     }
 
     template <typename R,
-              typename = std::enable_if_t<is_result_v<std::decay_t<R>>>>
-    inline result(const R &&aResult) noexcept : base(std::move(aResult))
+              typename = std::enable_if_t<std::conjunction_v<
+                  is_result<utils::remove_cvref_t<R>>,
+                  std::negation<std::is_lvalue_reference<R>>,
+                  std::negation<
+                      std::is_same<utils::remove_cvref_t<R>, basic_result>>>>>
+    inline basic_result(R &&aResult) noexcept : base(std::forward<R>(aResult))
     {
     }
 
-    inline void value() const noexcept
-    {
-        base::shared_state::enforce_value_state();
-    }
+    inline void value() const noexcept { base::enforce_value_state(); }
 };
 
 template <typename... Callbacks>
@@ -0,0 +1,99 @@
+// C++20 named module of tricky: `import tricky;` instead of including
+// tricky.h, context.h, context_pool.h and batch.h. Built by the tricky_module
+// target when TRICKY_MODULE is ON. Macros are not exported by modules, so
+// translation units using TRICKY_NEW_ERROR, TRICKY_ASSIGN and alike still
+// include <tricky/tricky.h>; the header and the module may be mixed freely.
+module;
+
+#include <tricky/batch.h>
+#include <tricky/context.h>
+#include <tricky/context_pool.h>
+#include <tricky/tricky.h>
+
+#ifdef TRICKY_COROUTINES
+#include <tricky/coroutine.h>
+#endif
+
+export module tricky;
+
+export namespace tricky
+{
+// results
+using tricky::basic_result;
+using tricky::inline_result;
+using tricky::is_result;
+using tricky::is_result_v;
+using tricky::niche_traits;
+using tricky::niche_traits_v;
+using tricky::process_payload;
+using tricky::result;
+
+// handlers
+using tricky::any_handler;
+using tricky::categories_handler;
+using tricky::handler;
+using tricky::handlers;
+using tricky::is_any_handler;
+using tricky::is_any_handler_v;
+using tricky::is_categories_handler;
+using tricky::is_categories_handler_v;
+using tricky::is_handlers;
+using tricky::is_handlers_v;
+using tricky::is_values_handler;
+using tricky::is_values_handler_v;
+using tricky::try_handle_all;
+using tricky::try_handle_some;
+using tricky::values_handler;
+
+// error state and payloads
+using tricky::defer;
+using tricky::deferred;
+using tricky::e_source_location;
+using tricky::kPayloadArena;
+using tricky::kPayloadArenaChunk;
+using tricky::kPayloadMaxSpace;
+using tricky::kPayloadStats;
+using tricky::kSwitchableState;
+using tricky::kThreadLocalState;
+using tricky::lazy_load;
+using tricky::on_error;
+using tricky::payload_arena;
+using tricky::payload_stats;
+using tricky::shared_state;
+
+// telemetry
+using tricky::error_record;
+using tricky::error_telemetry;
+using tricky::kErrorTelemetry;
+using tricky::kErrorTelemetryCapacity;
+
+// contexts
+using tricky::context;
+using tricky::context_activator;
+using tricky::context_pool;
+using tricky::error;
+using tricky::error_spill;
+using tricky::heavy_context;
+using tricky::is_context;
+using tricky::is_context_v;
+using tricky::kContextPoolPayloadSize;
+using tricky::kErrorInlineSize;
+using tricky::polymorphic_context;
+
+// batches and scans
+using tricky::best_scan_isa;
+using tricky::compress_values;
+using tricky::contains_error;
+using tricky::count_indices;
+using tricky::find_first_error;
+using tricky::kScanRuntimeDispatch;
+using tricky::result_batch;
+using tricky::scan_isa;
+using tricky::scan_isa_supported;
+
+#ifdef TRICKY_COROUTINES
+// coroutines
+using tricky::sync_wait;
+using tricky::task;
+#endif
+}  // namespace tricky
@@ -0,0 +1,2 @@
+// Empty translation unit of tricky_pch: CMake compiles the precompiled tricky
+// headers along with it, and targets passed to tricky_reuse_pch() reuse them.
@@ -0,0 +1,25 @@
+// Definitions of the error state for TRICKY_STATE_DSO, compiled into the
+// shared library built by tricky_add_state_library() only.
+#include <tricky/context.h>
+#include <tricky/state.h>
+
+#ifndef TRICKY_STATE_EXPORT
+#error "state.cpp belongs to the library built by tricky_add_state_library()"
+#endif
+
+namespace tricky
+{
+namespace details
+{
+#ifdef TRICKY_COROUTINES
+thread_local state *shared_state::current_{nullptr};
+#endif
+TRICKY_STATE_STORAGE state shared_state::state_{};
+}  // namespace details
+
+polymorphic_context *&polymorphic_context::active_context() noexcept
+{
+    thread_local polymorphic_context *active_context = nullptr;
+    return active_context;
+}
+}  // namespace tricky
@@ -0,0 +1,87 @@
+# Checks the assembly ASM produced from SOURCE against the limits annotated
+# in SOURCE with "// codegen: <function> max_instructions=N max_calls=N".
+# Usage:
+#   cmake -DASM=<file.s> -DSOURCE=<file.cpp> -P check_codegen.cmake
+set(kForbiddenCalls "shared_state|payload|cargo|_Znw|_Zdl|__cxa_|_Unwind|assert")
+set(kCallMnemonics "call|callq|bl|blr|blx")
+set(kJumpMnemonics "jmp|jmpq|b|br")
+
+file(STRINGS "${SOURCE}" annotations REGEX "^// codegen: [A-Za-z_0-9]+ ")
+if(NOT annotations)
+  message(FATAL_ERROR "codegen: no annotated functions in ${SOURCE}")
+endif()
+file(STRINGS "${ASM}" asm_lines)
+
+set(failed FALSE)
+foreach(annotation IN LISTS annotations)
+  string(REGEX MATCH "^// codegen: ([A-Za-z_0-9]+)" _ "${annotation}")
+  set(function "${CMAKE_MATCH_1}")
+  set(max_instructions "")
+  set(max_calls "")
+  if(annotation MATCHES "max_instructions=([0-9]+)")
+    set(max_instructions "${CMAKE_MATCH_1}")
+  endif()
+  if(annotation MATCHES "max_calls=([0-9]+)")
+    set(max_calls "${CMAKE_MATCH_1}")
+  endif()
+
+  # Mangled name of a function from the global namespace, with the leading
+  # underscore of Mach-O targets.
+  string(LENGTH "${function}" length)
+  set(label "^_?_Z${length}${function}[A-Za-z_0-9]*:")
+
+  set(inside FALSE)
+  set(found FALSE)
+  set(instructions 0)
+  set(calls 0)
+  foreach(line IN LISTS asm_lines)
+    if(NOT inside)
+      if(line MATCHES "${label}")
+        set(inside TRUE)
+        set(found TRUE)
+      endif()
+      continue()
+    endif()
+    if(line MATCHES "^[ \t]*\\.(cfi_endproc|size)" OR
+       line MATCHES "^_?_Z[A-Za-z_0-9]*:")
+      break()
+    endif()
+    # skip labels, directives and comments
+    if(line MATCHES "^[^ \t]" OR line MATCHES "^[ \t]*([.#;@]|//|$)")
+      continue()
+    endif()
+    math(EXPR instructions "${instructions} + 1")
+    string(STRIP "${line}" line)
+    if(line MATCHES "^(${kCallMnemonics})[ \t]")
+      math(EXPR calls "${calls} + 1")
+    endif()
+    if(line MATCHES "^(${kCallMnemonics}|${kJumpMnemonics})[ \t]" AND
+       line MATCHES "${kForbiddenCalls}")
+      message(SEND_ERROR "codegen: ${function} calls: ${line}")
+      set(failed TRUE)
+    endif()
+  endforeach()
+
+  if(NOT found)
+    message(SEND_ERROR "codegen: ${function} was not found in ${ASM}")
+    set(failed TRUE)
+    continue()
+  endif()
+  if(NOT max_instructions STREQUAL "" AND
+     instructions GREATER max_instructions)
+    message(SEND_ERROR "codegen: ${function} has ${instructions} "
+                       "instructions, at most ${max_instructions} allowed")
+    set(failed TRUE)
+  endif()
+  if(NOT max_calls STREQUAL "" AND calls GREATER max_calls)
+    message(SEND_ERROR "codegen: ${function} has ${calls} calls, "
+                       "at most ${max_calls} allowed")
+    set(failed TRUE)
+  endif()
+  message(STATUS "codegen: ${function}: ${instructions} instructions, "
+                 "${calls} calls")
+endforeach()
+
+if(failed)
+  message(FATAL_ERROR "codegen: success path overhead regression")
+endif()
@@ -0,0 +1,82 @@
+// Functions whose -O2 assembly is checked by check_codegen.cmake. Every
+// "// codegen:" line names a function defined below and the limits for its
+// whole body (success and failure paths together):
+//   max_instructions=N  at most N instructions
+//   max_calls=N         at most N call instructions
+// Calls to shared_state, cargo::payload, the allocator, exception support
+// and assert are never allowed (see kForbiddenCalls in check_codegen.cmake).
+#include <tricky/tricky.h>
+
+#include <cstdint>
+
+// named so that the annotated functions keep external linkage
+namespace codegen
+{
+enum class eReaderError : std::uint8_t
+{
+    kError1,
+    kError2
+};
+
+enum class eFileError : std::uint8_t
+{
+    kEOF,
+    kPermission
+};
+}  // namespace codegen
+
+using result =
+    tricky::result<int, codegen::eReaderError, codegen::eFileError>;
+using inline_result =
+    tricky::inline_result<int, codegen::eReaderError, codegen::eFileError>;
+using narrow_result = tricky::result<int, codegen::eReaderError>;
+
+// defined elsewhere so that the compiler can not see the results
+result codegen_source(int aValue) noexcept;
+inline_result codegen_inline_source(int aValue) noexcept;
+narrow_result codegen_narrow_source(int aValue) noexcept;
+
+// codegen: codegen_return_value max_instructions=4 max_calls=0
+result codegen_return_value(int aValue) noexcept { return aValue; }
+
+// codegen: codegen_inline_return_value max_instructions=4 max_calls=0
+inline_result codegen_inline_return_value(int aValue) noexcept
+{
+    return aValue;
+}
+
+// codegen: codegen_assign max_instructions=16 max_calls=1
+result codegen_assign(int aValue) noexcept
+{
+    TRICKY_AUTO(value, codegen_source(aValue));
+    return value + 1;
+}
+
+// codegen: codegen_assign_twice max_instructions=40 max_calls=2
+result codegen_assign_twice(int aValue) noexcept
+{
+    TRICKY_AUTO(first, codegen_source(aValue));
+    TRICKY_AUTO(second, codegen_source(first));
+    return first + second;
+}
+
+// codegen: codegen_inline_assign max_instructions=20 max_calls=1
+inline_result codegen_inline_assign(int aValue) noexcept
+{
+    TRICKY_AUTO(value, codegen_inline_source(aValue));
+    return value + 1;
+}
+
+// codegen: codegen_assign_converted max_instructions=24 max_calls=1
+result codegen_assign_converted(int aValue) noexcept
+{
+    TRICKY_AUTO(value, codegen_narrow_source(aValue));
+    return value + 1;
+}
+
+// codegen: codegen_unwrap max_instructions=12 max_calls=1
+int codegen_unwrap(int aValue) noexcept
+{
+    const result r = codegen_source(aValue);
+    return r ? r.value() : -1;
+}
@@ -0,0 +1,43 @@
+#ifndef tricky_state_dso_h
+#define tricky_state_dso_h
+
+#include <cstddef>
+
+#include "test_common.h"
+
+// Interface of the state_dso_raise and state_dso_observe shared libraries of
+// state_dso_tests. Both are built with hidden visibility.
+#ifdef _WIN32
+#define STATE_DSO_EXPORT __declspec(dllexport)
+#define STATE_DSO_IMPORT __declspec(dllimport)
+#else
+#define STATE_DSO_EXPORT __attribute__((visibility("default")))
+#define STATE_DSO_IMPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef STATE_DSO_RAISE_BUILD
+#define STATE_DSO_RAISE_API STATE_DSO_EXPORT
+#else
+#define STATE_DSO_RAISE_API STATE_DSO_IMPORT
+#endif
+
+#ifdef STATE_DSO_OBSERVE_BUILD
+#define STATE_DSO_OBSERVE_API STATE_DSO_EXPORT
+#else
+#define STATE_DSO_OBSERVE_API STATE_DSO_IMPORT
+#endif
+
+namespace state_dso
+{
+// state_dso_raise
+STATE_DSO_RAISE_API test_utils::result<int> read(int aValue) noexcept;
+STATE_DSO_RAISE_API const void *raise_side_payload() noexcept;
+
+// state_dso_observe
+STATE_DSO_OBSERVE_API bool observed_error() noexcept;
+STATE_DSO_OBSERVE_API std::size_t observed_type_index() noexcept;
+STATE_DSO_OBSERVE_API const void *observe_side_payload() noexcept;
+STATE_DSO_OBSERVE_API void handle_error() noexcept;
+}  // namespace state_dso
+
+#endif /* tricky_state_dso_h */
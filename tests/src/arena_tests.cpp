@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <tricky/tricky.h>
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+
+#include "test_common.h"
+
+namespace
+{
+using namespace test_utils;
+
+static_assert(tricky::kPayloadArena,
+              "arena_tests must be built with TRICKY_PAYLOAD_ARENA");
+
+// Upstream resource which counts what the arena takes from it.
+class counting_resource : public std::pmr::memory_resource
+{
+   public:
+    std::size_t allocations{};
+    std::size_t deallocations{};
+    std::size_t bytes{};
+
+   private:
+    void *do_allocate(std::size_t aBytes, std::size_t aAlignment) override
+    {
+        ++allocations;
+        bytes += aBytes;
+        return std::pmr::new_delete_resource()->allocate(aBytes, aAlignment);
+    }
+
+    void do_deallocate(void *aPtr, std::size_t aBytes,
+                       std::size_t aAlignment) override
+    {
+        ++deallocations;
+        bytes -= aBytes;
+        std::pmr::new_delete_resource()->deallocate(aPtr, aBytes, aAlignment);
+    }
+
+    bool do_is_equal(
+        const std::pmr::memory_resource &aOther) const noexcept override
+    {
+        return this == &aOther;
+    }
+};
+
+struct large_payload
+{
+    std::array<char, 1000> text;
+};
+
+large_payload make_large_payload() noexcept
+{
+    large_payload payload{};
+    for (std::size_t i = 0; i < payload.text.size(); ++i)
+    {
+        payload.text[i] = static_cast<char>('a' + i % 26);
+    }
+    return payload;
+}
+
+bool has_large_payload() noexcept
+{
+    bool found = false;
+    tricky::process_payload(
+        [&found](const large_payload &aPayload) noexcept
+        { found = aPayload.text == make_large_payload().text; });
+    return found;
+}
+
+class PayloadArenaTest : public ::testing::Test
+{
+   protected:
+    void SetUp() override
+    {
+        tricky::shared_state::payload_capacity(tricky::kPayloadMaxSpace);
+    }
+    void TearDown() override
+    {
+        tricky::shared_state::reset();
+        tricky::shared_state::payload_upstream(
+            std::pmr::get_default_resource());
+    }
+};
+}  // namespace
+
+TEST(PayloadArenaUnitTest, AllocatesAlignedMemoryInChunks)
+{
+    counting_resource upstream;
+    {
+        tricky::payload_arena arena(256, &upstream);
+        auto *first = static_cast<char *>(arena.allocate(10, 1));
+        auto *second = static_cast<char *>(arena.allocate(8, 8));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(second) % 8, 0);
+        ASSERT_GE(second, first + 10);
+        ASSERT_EQ(upstream.allocations, 1);
+
+        // larger than a chunk: gets a chunk of its own
+        ASSERT_NE(arena.allocate(1000), nullptr);
+        ASSERT_EQ(upstream.allocations, 2);
+        ASSERT_EQ(arena.reserved(), upstream.bytes);
+    }
+    ASSERT_EQ(upstream.deallocations, upstream.allocations);
+    ASSERT_EQ(upstream.bytes, 0);
+}
+
+TEST(PayloadArenaUnitTest, RewindReusesChunks)
+{
+    counting_resource upstream;
+    tricky::payload_arena arena(256, &upstream);
+    void *first = arena.allocate(100);
+    arena.allocate(200);
+    arena.allocate(100);
+    const std::size_t kAllocations = upstream.allocations;
+
+    arena.rewind();
+    ASSERT_EQ(arena.allocate(100), first);
+    arena.allocate(200);
+    arena.allocate(100);
+    ASSERT_EQ(upstream.allocations, kAllocations);
+
+    arena.release();
+    ASSERT_EQ(upstream.bytes, 0);
+}
+
+TEST_F(PayloadArenaTest, LargePayloadWithRaisedCapacity)
+{
+    tricky::shared_state::payload_capacity(4096);
+    result<int> r{eFileError::kEOF, make_large_payload()};
+    ASSERT_TRUE(has_large_payload());
+}
+
+TEST_F(PayloadArenaTest, RejectedPayloadGrowsNextBuffer)
+{
+    {
+        result<int> r{eFileError::kEOF, make_large_payload()};
+        ASSERT_FALSE(has_large_payload());
+        tricky::shared_state::reset();
+    }
+    ASSERT_GE(tricky::shared_state::payload_capacity(),
+              sizeof(large_payload));
+
+    result<int> r{eFileError::kEOF, make_large_payload()};
+    ASSERT_TRUE(has_large_payload());
+}
+
+TEST_F(PayloadArenaTest, PayloadFromUserPool)
+{
+    counting_resource pool;
+    tricky::shared_state::payload_upstream(&pool);
+    ASSERT_EQ(pool.allocations, 1);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        result<int> r{eReaderError::kError1, i, 'c'};
+        tricky::shared_state::reset();
+    }
+    // reset() rewinds the arena instead of allocating again
+    ASSERT_EQ(pool.allocations, 1);
+
+    tricky::shared_state::payload_upstream(std::pmr::get_default_resource());
+    ASSERT_EQ(pool.bytes, 0);
+}
+
+TEST_F(PayloadArenaTest, ZeroCapacityGrows)
+{
+    tricky::shared_state::payload_capacity(0);
+    {
+        result<int> r{eFileError::kEOF, make_large_payload()};
+        ASSERT_FALSE(has_large_payload());
+        tricky::shared_state::reset();
+    }
+    ASSERT_GE(tricky::shared_state::payload_capacity(),
+              sizeof(large_payload));
+
+    result<int> r{eFileError::kEOF, make_large_payload()};
+    ASSERT_TRUE(has_large_payload());
+}
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <tricky/batch.h>
+
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "test_common.h"
+
+namespace
+{
+using namespace test_utils;
+
+using batch = tricky::result_batch<int, eReaderError, eFileError>;
+
+batch make_batch()
+{
+    batch b;
+    b.push_value(10);
+    b.push_error(eFileError::kEOF);
+    b.push_value(11);
+    b.push_value(12);
+    b.push_error(eReaderError::kError2);
+    b.push_value(13);
+    return b;
+}
+
+const auto to_int = tricky::handlers(
+    tricky::handler<eFileError>([](eFileError aError) noexcept
+                                { return -10 - static_cast<int>(aError); }),
+    tricky::handler([](auto aError) noexcept
+                    { return -static_cast<int>(aError) - 1; }));
+}  // namespace
+
+TEST(ResultBatchTest, Layout)
+{
+    const batch b = make_batch();
+    ASSERT_EQ(b.size(), 6);
+    ASSERT_EQ(b.error_count(), 2);
+
+    const std::vector<int> values(b.values(), b.values() + b.size());
+    ASSERT_EQ(values, (std::vector<int>{10, 0, 11, 12, 0, 13}));
+
+    const std::vector<batch::index_t> indices(b.indices(),
+                                              b.indices() + b.size());
+    ASSERT_EQ(indices, (std::vector<batch::index_t>{0, 2, 0, 0, 1, 0}));
+    ASSERT_TRUE(b.has_error(1));
+    ASSERT_FALSE(b.has_error(2));
+}
+
+TEST(ResultBatchTest, Lane)
+{
+    const batch b = make_batch();
+    ASSERT_EQ(to_int(b[0]), 10);
+    ASSERT_EQ(to_int(b[1]), -10 - utils::to_underlying(eFileError::kEOF));
+    ASSERT_EQ(to_int(b[4]),
+              -utils::to_underlying(eReaderError::kError2) - 1);
+    ASSERT_EQ(to_int(b[5]), 13);
+}
+
+TEST(ResultBatchTest, HandleAll)
+{
+    const batch b = make_batch();
+    std::vector<int> out;
+    b.handle_all(to_int, std::back_inserter(out));
+    ASSERT_EQ(out,
+              (std::vector<int>{10,
+                                -10 - utils::to_underlying(eFileError::kEOF),
+                                11, 12,
+                                -utils::to_underlying(eReaderError::kError2) -
+                                    1,
+                                13}));
+    ASSERT_FALSE(tricky::shared_state::has_error());
+}
+
+TEST(ResultBatchTest, HandleAllWithoutErrors)
+{
+    batch b;
+    for (int i = 0; i < 100; ++i)
+    {
+        b.push_value(i);
+    }
+    std::vector<int> out(b.size());
+    ASSERT_EQ(b.handle_all(to_int, out.data()), out.data() + out.size());
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_EQ(out[static_cast<std::size_t>(i)], i);
+    }
+}
+
+TEST(ResultBatchTest, ForEach)
+{
+    const batch b = make_batch();
+    std::vector<std::size_t> value_lanes;
+    int value_sum = 0;
+    std::vector<int> errors;
+    b.for_each(
+        [&](std::size_t aLane, int aValue)
+        {
+            value_lanes.push_back(aLane);
+            value_sum += aValue;
+        },
+        tricky::handlers(tricky::handler(
+            [&errors](auto aError) noexcept
+            {
+                errors.push_back(static_cast<int>(aError));
+                return 0;
+            })));
+    ASSERT_EQ(value_lanes, (std::vector<std::size_t>{0, 2, 3, 5}));
+    ASSERT_EQ(value_sum, 46);
+    ASSERT_EQ(errors,
+              (std::vector<int>{utils::to_underlying(eFileError::kEOF),
+                                utils::to_underlying(eReaderError::kError2)}));
+}
+
+TEST(ResultBatchTest, NonTrivialValues)
+{
+    tricky::result_batch<std::string, eFileError> b;
+    b.push_value(std::string(100, 'a'));
+    b.push_error(eFileError::kPermission);
+    const auto first = b[0];
+    ASSERT_TRUE(first.has_value());
+    ASSERT_EQ(first.value(), std::string(100, 'a'));
+    ASSERT_TRUE(b[1].has_error());
+    b.clear();
+    ASSERT_TRUE(b.empty());
+    ASSERT_EQ(b.error_count(), 0);
+}
+
+TEST(ResultBatchTest, PendingSharedErrorSurvives)
+{
+    result<int> pending{eFileError::kPermission, 'p'};
+    const batch b = make_batch();
+    std::vector<int> out;
+    b.handle_all(to_int, std::back_inserter(out));
+    b.for_each([](std::size_t, int) {}, to_int);
+    ASSERT_EQ(to_int(b[1]), -10 - utils::to_underlying(eFileError::kEOF));
+
+    ASSERT_TRUE(tricky::shared_state::has_error());
+    ASSERT_EQ(pending.error<eFileError>(), eFileError::kPermission);
+    ASSERT_EQ(to_int(std::move(pending)),
+              -10 - utils::to_underlying(eFileError::kPermission));
+    ASSERT_FALSE(tricky::shared_state::has_error());
+}
+
+namespace
+{
+// default construction of a failed lane throws on demand
+struct fragile
+{
+    fragile()
+    {
+        if (fail)
+        {
+            throw std::runtime_error("fragile");
+        }
+    }
+    explicit fragile(int aValue) : value(aValue) {}
+
+    static inline bool fail = false;
+    int value{};
+};
+}  // namespace
+
+TEST(ResultBatchTest, FailedPushLeavesBatchIntact)
+{
+    tricky::result_batch<fragile, eFileError> b;
+    b.push_value(fragile{1});
+    b.push_error(eFileError::kEOF);
+
+    fragile::fail = true;
+    ASSERT_THROW(b.push_error(eFileError::kPermission), std::runtime_error);
+    fragile::fail = false;
+
+    ASSERT_EQ(b.size(), 2);
+    ASSERT_EQ(b.error_count(), 1);
+    b.push_error(eFileError::kPermission);
+    ASSERT_EQ(b.size(), 3);
+    ASSERT_EQ(b.error_count(), 2);
+    ASSERT_TRUE(b.has_error(2));
+    ASSERT_EQ(b.error_counts()[1], 2);
+}
@@ -0,0 +1,195 @@
+#include <cargo/cargo.h>
+#include <gtest/gtest.h>
+#include <tricky/context_pool.h>
+
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "test_common.h"
+
+namespace
+{
+using namespace test_utils;
+using payload = cargo::payload;
+using context =
+    tricky::heavy_context<payload, eReaderError, eWriterError, eFileError>;
+
+// every test takes its own pool, the pools are process wide
+template <std::size_t PayloadSize>
+using pool = tricky::context_pool<context, PayloadSize>;
+}  // namespace
+
+TEST(ContextPoolTest, StaticChecks)
+{
+    using handle = pool<64>::handle;
+    static_assert(not std::is_copy_constructible_v<handle>);
+    static_assert(not std::is_copy_assignable_v<handle>);
+    static_assert(std::is_nothrow_move_constructible_v<handle>);
+    static_assert(std::is_nothrow_move_assignable_v<handle>);
+    static_assert(pool<64>::payload_size == 64);
+}
+
+TEST(ContextPoolTest, RecyclesContexts)
+{
+    using p = pool<72>;
+    const context *first = nullptr;
+    {
+        auto h = p::acquire();
+        ASSERT_TRUE(h);
+        ASSERT_FALSE(h->has_error());
+        ASSERT_TRUE(h->payload().data());
+        first = &*h;
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        auto h = p::acquire();
+        ASSERT_EQ(&*h, first);
+    }
+    ASSERT_EQ(p::allocated(), 1);
+}
+
+TEST(ContextPoolTest, ResetsPayloadAndError)
+{
+    using p = pool<80>;
+    {
+        auto h = p::acquire();
+        ASSERT_TRUE(h->payload().load(42));
+        ASSERT_NE(h->payload().size(), 0);
+        tricky::details::ctx::set_error(eFileError::kEOF, *h);
+        ASSERT_TRUE(h->has_error<eFileError>());
+        tricky::details::ctx::reset_error(*h);
+    }
+    auto h = p::acquire();
+    ASSERT_FALSE(h->has_error());
+    ASSERT_EQ(h->payload().size(), 0);
+    ASSERT_EQ(p::allocated(), 1);
+}
+
+TEST(ContextPoolTest, MoveHandle)
+{
+    using p = pool<88>;
+    auto h = p::acquire();
+    const context *ctx = &*h;
+
+    auto h2 = std::move(h);
+    ASSERT_FALSE(h);
+    ASSERT_EQ(&*h2, ctx);
+
+    p::handle h3;
+    ASSERT_FALSE(h3);
+    h3 = std::move(h2);
+    ASSERT_EQ(&*h3, ctx);
+
+    h3.reset();
+    ASSERT_FALSE(h3);
+    ASSERT_EQ(&*p::acquire(), ctx);
+}
+
+TEST(ContextPoolTest, ReturnFromAnotherThread)
+{
+    using p = pool<96>;
+    constexpr std::size_t kCount = 16;
+    std::vector<p::handle> handles;
+    for (std::size_t i = 0; i < kCount; ++i)
+    {
+        handles.push_back(p::acquire());
+    }
+    ASSERT_EQ(p::allocated(), kCount);
+
+    std::thread([&handles] { handles.clear(); }).join();
+
+    // the contexts went back to the free list of this thread
+    for (std::size_t i = 0; i < kCount; ++i)
+    {
+        handles.push_back(p::acquire());
+    }
+    ASSERT_EQ(p::allocated(), kCount);
+}
+
+TEST(ContextPoolTest, ExitedThreadListIsReused)
+{
+    using p = pool<104>;
+    std::thread([] { p::acquire(); }).join();
+    ASSERT_EQ(p::allocated(), 1);
+    std::thread([] { p::acquire(); }).join();
+    ASSERT_EQ(p::allocated(), 1);
+}
+
+TEST(ContextPoolTest, ReleaseDuringThreadExit)
+{
+    using p = pool<120>;
+    // destroyed after the owner of the free list of the thread, which is
+    // constructed later by acquire()
+    struct parked
+    {
+        p::handle handle;
+    };
+    std::thread(
+        []
+        {
+            thread_local parked last;
+            last.handle = p::acquire();
+        })
+        .join();
+    ASSERT_EQ(p::allocated(), 1);
+
+    // the context went back to the free list of the exited thread
+    std::thread([] { p::acquire(); }).join();
+    ASSERT_EQ(p::allocated(), 1);
+}
+
+TEST(ContextPoolTest, Churn)
+{
+    using p = pool<112>;
+    constexpr std::size_t kThreadCount = 4;
+    constexpr std::size_t kBatch = 8;
+    constexpr std::size_t kRounds = 2000;
+
+    struct slot
+    {
+        std::mutex mutex;
+        std::vector<p::handle> handles;
+    };
+
+    // every thread hands its contexts to the next one and releases the
+    // contexts it got from the previous one
+    std::vector<slot> slots(kThreadCount);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < kThreadCount; ++t)
+    {
+        threads.emplace_back(
+            [&slots, t]
+            {
+                slot &next = slots[(t + 1) % kThreadCount];
+                for (std::size_t round = 0; round < kRounds; ++round)
+                {
+                    std::vector<p::handle> batch;
+                    for (std::size_t i = 0; i < kBatch; ++i)
+                    {
+                        batch.push_back(p::acquire());
+                    }
+                    {
+                        std::lock_guard lock(next.mutex);
+                        std::swap(next.handles, batch);
+                    }
+                }
+            });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    for (auto &s : slots)
+    {
+        for (const auto &h : s.handles)
+        {
+            ASSERT_TRUE(h);
+        }
+        s.handles.clear();
+    }
+    // a thread's contexts are in its hands, in the next slot or being
+    // released by the next thread
+    ASSERT_LE(p::allocated(), 3 * kBatch * kThreadCount);
+}
@@ -2,6 +2,9 @@
 #include <gtest/gtest.h>
 #include <tricky/context.h>
 
+#include <array>
+#include <vector>
+
 #include "test_common.h"
 
 namespace
@@ -107,3 +110,288 @@ TEST_F(ContextTest, HasError)
     ASSERT_FALSE(ctx.has_error<eWriterError>());
     ASSERT_FALSE(ctx.has_error<eFileError>());
 }
+
+namespace
+{
+struct snapshot
+{
+    std::array<std::uint64_t, 16> words;
+};
+
+using mixed_context = tricky::heavy_context<payload, eReaderError, snapshot>;
+}  // namespace
+
+TEST(CtxTest, LargeErrorDoesNotGrowContext)
+{
+    static_assert(sizeof(mixed_context) < sizeof(snapshot));
+    static_assert(sizeof(mixed_context::error_t) ==
+                  sizeof(context::error_t));
+}
+
+TEST_F(ContextTest, LargeErrorSpills)
+{
+    mixed_context ctx(buffer_);
+    snapshot s{};
+    s.words[3] = 3;
+    tricky::details::ctx::set_error(s, ctx);
+
+    mixed_context ctx2(std::move(ctx));
+    ASSERT_FALSE(ctx.has_error());
+    ASSERT_TRUE(ctx2.has_error<snapshot>());
+    ASSERT_EQ(ctx2.get_error<snapshot>().words[3], 3);
+
+    tricky::details::ctx::reset_error(ctx2);
+}
+
+namespace
+{
+// not trivially copyable, so contexts holding it move their error through
+// tricky::error's move constructor
+struct tracked_error
+{
+    tracked_error() noexcept = default;
+    tracked_error(const tracked_error &aOther) noexcept : code(aOther.code) {}
+
+    int code{};
+};
+
+using relocatable_context = tricky::context<eReaderError, eFileError>;
+using tracked_context = tricky::context<eReaderError, tracked_error>;
+}  // namespace
+
+TEST(CtxTest, TriviallyRelocatableErrors)
+{
+    using error_t = relocatable_context::error_t;
+    static_assert(error_t::is_trivially_relocatable<eReaderError>);
+    static_assert(error_t::is_trivially_relocatable<eFileError>);
+    static_assert(
+        not tracked_context::error_t::is_trivially_relocatable<tracked_error>);
+}
+
+TEST(CtxTest, MoveChainKeepsError)
+{
+    relocatable_context ctx;
+    tricky::details::ctx::set_error(eFileError::kEOF, ctx);
+
+    relocatable_context ctx2(std::move(ctx));
+    relocatable_context ctx3;
+    ctx3 = std::move(ctx2);
+    relocatable_context ctx4(std::move(ctx3));
+
+    ASSERT_FALSE(ctx.has_error());
+    ASSERT_FALSE(ctx2.has_error());
+    ASSERT_FALSE(ctx3.has_error());
+    ASSERT_TRUE(ctx4.has_error<eFileError>());
+    ASSERT_EQ(ctx4.get_error<eFileError>(), eFileError::kEOF);
+
+    relocatable_context empty;
+    relocatable_context moved(std::move(empty));
+    ASSERT_FALSE(moved.has_error());
+
+    tricky::details::ctx::reset_error(ctx4);
+}
+
+TEST(CtxTest, MoveNonTrivialError)
+{
+    tracked_error e;
+    e.code = 9;
+    tracked_context ctx;
+    tricky::details::ctx::set_error(e, ctx);
+
+    tracked_context ctx2(std::move(ctx));
+    ASSERT_FALSE(ctx.has_error());
+    ASSERT_TRUE(ctx2.has_error<tracked_error>());
+    ASSERT_EQ(ctx2.get_error<tracked_error>().code, 9);
+
+    tricky::details::ctx::reset_error(ctx2);
+}
+
+namespace
+{
+using active_context = tricky::details::polymorphic_context_impl<
+    tricky::context<eReaderError, eFileError>>;
+using activator = tricky::context_activator<active_context>;
+}  // namespace
+
+TEST(CtxTest, ActivationIsNotVirtual)
+{
+    static_assert(not std::is_polymorphic_v<tricky::polymorphic_context>);
+    static_assert(not std::is_polymorphic_v<active_context>);
+}
+
+TEST(CtxTest, NestedActivation)
+{
+    active_context outer;
+    active_context inner;
+    ASSERT_EQ(tricky::polymorphic_context::current(), nullptr);
+    {
+        activator a(outer);
+        ASSERT_TRUE(outer.is_active());
+        ASSERT_EQ(tricky::polymorphic_context::current(), &outer);
+        {
+            activator b(inner);
+            ASSERT_TRUE(outer.is_active());
+            ASSERT_TRUE(inner.is_active());
+            ASSERT_EQ(tricky::polymorphic_context::current(), &inner);
+            ASSERT_EQ(inner.previous(), &outer);
+
+            // already on the stack, not pushed once more
+            activator c(outer);
+            ASSERT_EQ(tricky::polymorphic_context::current(), &inner);
+        }
+        ASSERT_FALSE(inner.is_active());
+        ASSERT_EQ(inner.previous(), nullptr);
+        ASSERT_EQ(tricky::polymorphic_context::current(), &outer);
+    }
+    ASSERT_FALSE(outer.is_active());
+    ASSERT_EQ(tricky::polymorphic_context::current(), nullptr);
+}
+
+TEST(CtxTest, DeepActivation)
+{
+    constexpr std::size_t kDepth = 64;
+    std::array<active_context, kDepth> contexts;
+    std::vector<activator> activators;
+    activators.reserve(kDepth);
+    for (auto &ctx : contexts)
+    {
+        activators.emplace_back(ctx);
+        ASSERT_EQ(tricky::polymorphic_context::current(), &ctx);
+    }
+    for (std::size_t i = kDepth; i-- > 0;)
+    {
+        ASSERT_EQ(tricky::polymorphic_context::current(), &contexts[i]);
+        activators.pop_back();
+    }
+    ASSERT_EQ(tricky::polymorphic_context::current(), nullptr);
+}
+
+TEST(CtxTest, ActivationThroughBase)
+{
+    active_context ctx;
+    tricky::polymorphic_context &base = ctx;
+    {
+        tricky::context_activator<tricky::polymorphic_context> a(base);
+        ASSERT_TRUE(ctx.is_active());
+        ASSERT_EQ(tricky::polymorphic_context::current(), &base);
+    }
+    ASSERT_FALSE(ctx.is_active());
+}
+
+namespace
+{
+using wide_context = tricky::context<eBigError, eFileError, snapshot,
+                                     tracked_error>;
+using active_wide_context =
+    tricky::details::polymorphic_context_impl<wide_context>;
+
+template <typename Context, typename E>
+void raise(tricky::details::polymorphic_context_impl<Context> &aCtx,
+           E aError)
+{
+    tricky::details::ctx::set_error(aError, static_cast<Context &>(aCtx));
+}
+
+template <typename Context>
+void handle(tricky::details::polymorphic_context_impl<Context> &aCtx)
+{
+    tricky::details::ctx::reset_error(static_cast<Context &>(aCtx));
+}
+}  // namespace
+
+TEST(CtxTest, ForwardErrorToOuterContext)
+{
+    active_wide_context outer;
+    active_context inner;
+    {
+        tricky::context_activator<active_wide_context> a(outer);
+        {
+            activator b(inner);
+            raise(inner, eFileError::kEOF);
+        }
+        ASSERT_FALSE(inner.has_error());
+        ASSERT_TRUE(outer.has_error<eFileError>());
+        ASSERT_EQ(outer.get_error<eFileError>(), eFileError::kEOF);
+    }
+    // the outermost context keeps the error
+    ASSERT_TRUE(outer.has_error<eFileError>());
+    handle(outer);
+}
+
+TEST(CtxTest, ForwardRelocatesError)
+{
+    active_wide_context outer;
+    active_wide_context inner;
+    tricky::context_activator<active_wide_context> a(outer);
+
+    snapshot s{};
+    s.words[5] = 5;
+    {
+        tricky::context_activator<active_wide_context> b(inner);
+        raise(inner, s);
+    }
+    ASSERT_EQ(outer.get_error<snapshot>().words[5], 5);
+    handle(outer);
+
+    tracked_error e;
+    e.code = 7;
+    {
+        tricky::context_activator<active_wide_context> b(inner);
+        raise(inner, e);
+    }
+    ASSERT_EQ(outer.get_error<tracked_error>().code, 7);
+    handle(outer);
+}
+
+TEST(CtxTest, ForwardKeepsErrorOuterCannotHold)
+{
+    active_context outer;
+    active_wide_context inner;
+    {
+        activator a(outer);
+        {
+            tricky::context_activator<active_wide_context> b(inner);
+            raise(inner, eBigError::kTwo);
+        }
+        ASSERT_FALSE(outer.has_error());
+        ASSERT_TRUE(inner.has_error<eBigError>());
+        handle(inner);
+
+        // the error which the outer context already has wins
+        raise(outer, eReaderError::kError1);
+        active_context second;
+        {
+            activator b(second);
+            raise(second, eFileError::kEOF);
+        }
+        ASSERT_TRUE(second.has_error<eFileError>());
+        handle(second);
+    }
+    ASSERT_TRUE(outer.has_error<eReaderError>());
+    handle(outer);
+}
+
+TEST(CtxTest, ForwardThroughDeepNesting)
+{
+    constexpr std::size_t kDepth = 64;
+    std::array<active_context, kDepth> contexts;
+    std::vector<activator> activators;
+    activators.reserve(kDepth);
+    for (auto &ctx : contexts)
+    {
+        activators.emplace_back(ctx);
+    }
+    raise(contexts.back(), eFileError::kPermission);
+
+    // every scope hands the error to the next outer one on exit
+    for (std::size_t i = kDepth; i-- > 1;)
+    {
+        activators.pop_back();
+        ASSERT_FALSE(contexts[i].has_error());
+        ASSERT_TRUE(contexts[i - 1].has_error<eFileError>());
+    }
+    activators.pop_back();
+    ASSERT_EQ(contexts.front().get_error<eFileError>(),
+              eFileError::kPermission);
+    handle(contexts.front());
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <tricky/coroutine.h>
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+static_assert(not tricky::shared_state::is_thread_local,
+              "coroutine_state_tests must be built without "
+              "TRICKY_THREAD_LOCAL_STATE");
+static_assert(tricky::shared_state::is_switchable,
+              "coroutine_state_tests must be built with TRICKY_COROUTINES");
+}  // namespace
+
+// Worker threads resuming coroutines of different frames activate different
+// states at the same time, even when the state of a thread is process wide.
+TEST(CoroutineStateTest, ActiveStateIsPerThread)
+{
+    std::atomic<int> activated{};
+    std::atomic<int> checked{};
+    std::atomic<int> failures{};
+    const auto worker = [&]()
+    {
+        tricky::details::state own;
+        tricky::details::state *previous =
+            tricky::shared_state::activate(&own);
+        // both states are active before either thread looks at its own
+        ++activated;
+        while (activated.load() != 2)
+        {
+            std::this_thread::yield();
+        }
+        if (previous || tricky::shared_state::active() != &own)
+        {
+            ++failures;
+        }
+        ++checked;
+        while (checked.load() != 2)
+        {
+            std::this_thread::yield();
+        }
+        tricky::shared_state::activate(previous);
+    };
+
+    std::thread first(worker);
+    std::thread second(worker);
+    first.join();
+    second.join();
+    ASSERT_EQ(failures.load(), 0);
+}
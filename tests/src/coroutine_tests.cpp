@@ -0,0 +1,293 @@
+#include <gtest/gtest.h>
+#include <tricky/coroutine.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// test_common.h is not used: its u8 literals do not compile as C++20
+enum class eReaderError : std::uint8_t
+{
+    kError1,
+    kError2
+};
+
+enum class eWriterError : std::uint8_t
+{
+    kError3,
+    kError4
+};
+
+enum class eFileError : std::uint8_t
+{
+    kEOF,
+    kPermission
+};
+
+template <typename T>
+using result = tricky::result<T, eReaderError, eWriterError, eFileError>;
+
+namespace reader
+{
+template <typename T>
+using result = tricky::result<T, eReaderError>;
+}
+
+static_assert(tricky::shared_state::is_thread_local,
+              "coroutine_tests must be built with TRICKY_THREAD_LOCAL_STATE");
+static_assert(tricky::shared_state::is_switchable,
+              "coroutine_tests must be built with TRICKY_COROUTINES");
+
+// Executor resuming coroutines on a fixed set of worker threads.
+class thread_pool
+{
+   public:
+    explicit thread_pool(std::size_t aThreadCount)
+    {
+        for (std::size_t i = 0; i < aThreadCount; ++i)
+        {
+            threads_.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        ready_.notify_all();
+        for (auto &thread: threads_)
+        {
+            thread.join();
+        }
+    }
+
+    auto schedule() noexcept
+    {
+        struct awaiter
+        {
+            thread_pool &pool_;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> aHandle) const
+            {
+                pool_.post(aHandle);
+            }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{*this};
+    }
+
+   private:
+    void post(std::coroutine_handle<> aHandle)
+    {
+        {
+            std::lock_guard lock(mutex_);
+            queue_.push_back(aHandle);
+        }
+        ready_.notify_one();
+    }
+
+    void run()
+    {
+        for (;;)
+        {
+            std::coroutine_handle<> handle;
+            {
+                std::unique_lock lock(mutex_);
+                ready_.wait(lock,
+                            [this]() { return stop_ || !queue_.empty(); });
+                if (queue_.empty())
+                {
+                    return;
+                }
+                handle = queue_.front();
+                queue_.pop_front();
+            }
+            handle.resume();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::coroutine_handle<>> queue_;
+    std::vector<std::thread> threads_;
+    bool stop_{};
+};
+
+const auto handle_any = tricky::handlers(tricky::handler(
+    [](auto aError) noexcept { return -static_cast<int>(aError) - 1; }));
+
+tricky::task<result<int>> make_value(int aValue)
+{
+    co_return aValue;
+}
+
+tricky::task<reader::result<int>> make_error(thread_pool &aPool, int aPayload)
+{
+    co_await aPool.schedule();
+    co_return reader::result<int>{eReaderError::kError2, aPayload};
+}
+
+// longer than any small string buffer, so a moved-from copy is empty
+const std::string kText(100, 't');
+
+tricky::task<result<std::string>> make_text(thread_pool &aPool)
+{
+    co_await aPool.schedule();
+    co_return kText;
+}
+
+tricky::task<result<std::string>> quote_text(thread_pool &aPool)
+{
+    TRICKY_CO_AUTO(text, co_await make_text(aPool));
+    co_return "'" + text + "'";
+}
+
+tricky::task<result<int>> add_one(thread_pool &aPool, bool aFail)
+{
+    TRICKY_CO_AUTO(value, co_await make_value(aFail ? -1 : 41));
+    if (aFail)
+    {
+        TRICKY_CO_AUTO(never, co_await make_error(aPool, value));
+        static_cast<void>(never);
+    }
+    co_return value + 1;
+}
+}  // namespace
+
+TEST(CoroutineTest, Value)
+{
+    auto r = tricky::sync_wait(make_value(7));
+    ASSERT_TRUE(r.has_value());
+    ASSERT_EQ(r.value(), 7);
+}
+
+TEST(CoroutineTest, ErrorWithPayloadReachesCaller)
+{
+    thread_pool pool(2);
+    auto r = tricky::sync_wait(make_error(pool, 13));
+    ASSERT_TRUE(r.has_error());
+    ASSERT_TRUE(tricky::shared_state::has_error());
+
+    int payload = 0;
+    const auto kValue = tricky::handlers(tricky::handler(
+        [&payload](auto aError) noexcept
+        {
+            tricky::process_payload([&payload](int aPayload) noexcept
+                                    { payload = aPayload; });
+            return static_cast<int>(aError);
+        }))(std::move(r));
+    ASSERT_EQ(kValue, utils::to_underlying(eReaderError::kError2));
+    ASSERT_EQ(payload, 13);
+    ASSERT_FALSE(tricky::shared_state::has_error());
+}
+
+TEST(CoroutineTest, CoAssignPropagatesError)
+{
+    thread_pool pool(2);
+    ASSERT_EQ(handle_any(tricky::sync_wait(add_one(pool, false))), 42);
+    ASSERT_EQ(handle_any(tricky::sync_wait(add_one(pool, true))),
+              -utils::to_underlying(eReaderError::kError2) - 1);
+    ASSERT_FALSE(tricky::shared_state::has_error());
+}
+
+TEST(CoroutineTest, NonTrivialValueIsMovedOnce)
+{
+    thread_pool pool(2);
+    auto r = tricky::sync_wait(make_text(pool));
+    ASSERT_TRUE(r.has_value());
+    ASSERT_EQ(r.value(), kText);
+
+    auto quoted = tricky::sync_wait(quote_text(pool));
+    ASSERT_TRUE(quoted.has_value());
+    ASSERT_EQ(quoted.value(), "'" + kText + "'");
+}
+
+TEST(CoroutineTest, PendingErrorMovesWithFrame)
+{
+    thread_pool pool(4);
+    const auto body = [&pool]() -> tricky::task<result<int>>
+    {
+        co_await pool.schedule();
+        result<int> r{eFileError::kPermission};
+        const auto kFirstThread = std::this_thread::get_id();
+        // suspend with the error pending until resumed on another thread
+        for (int i = 0; i < 1000; ++i)
+        {
+            co_await pool.schedule();
+            if (!r.has_error() || !tricky::shared_state::has_error())
+            {
+                co_return result<int>{-1};
+            }
+            if (std::this_thread::get_id() != kFirstThread)
+            {
+                break;
+            }
+        }
+        co_return std::move(r);
+    };
+    ASSERT_EQ(handle_any(tricky::sync_wait(body())),
+              -utils::to_underlying(eFileError::kPermission) - 1);
+}
+
+TEST(CoroutineTest, InterleavedTasksDoNotShareErrors)
+{
+    constexpr std::size_t kCallers = 8;
+    constexpr int kHops = 200;
+    thread_pool pool(2);
+    std::atomic<std::size_t> failures{};
+
+    const auto body = [&pool, &failures](std::size_t aCaller)
+        -> tricky::task<result<int>>
+    {
+        co_await pool.schedule();
+        if (tricky::shared_state::has_error())
+        {
+            ++failures;
+        }
+        const bool kIsFailing = aCaller % 2;
+        result<int> r = kIsFailing ? result<int>{eWriterError::kError4}
+                                   : result<int>{static_cast<int>(aCaller)};
+        for (int i = 0; i < kHops; ++i)
+        {
+            co_await pool.schedule();
+            if (tricky::shared_state::has_error() != kIsFailing)
+            {
+                ++failures;
+            }
+        }
+        co_return std::move(r);
+    };
+
+    std::vector<std::thread> callers;
+    for (std::size_t c = 0; c < kCallers; ++c)
+    {
+        callers.emplace_back(
+            [c, &body, &failures]()
+            {
+                const int kExpected =
+                    c % 2 ? -utils::to_underlying(eWriterError::kError4) - 1
+                          : static_cast<int>(c);
+                if (handle_any(tricky::sync_wait(body(c))) != kExpected ||
+                    tricky::shared_state::has_error())
+                {
+                    ++failures;
+                }
+            });
+    }
+    for (auto &caller: callers)
+    {
+        caller.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+}
@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include <tricky/error.h>
 
+#include <array>
+#include <memory_resource>
+#include <system_error>
+
 #include "test_common.h"
 
 namespace
@@ -58,3 +62,127 @@ TEST(ErrorTest, MoveAssignment)
     ASSERT_FALSE(e.contains<eReaderError>());
     ASSERT_EQ(e.type_name(), std::string_view());
 }
+
+namespace
+{
+struct snapshot
+{
+    std::array<std::uint64_t, 16> words;
+};
+
+// counts its live objects, so not trivially copyable
+struct tracked
+{
+    explicit tracked(int aValue) noexcept : value(aValue) { ++alive; }
+    tracked(const tracked &aOther) noexcept : value(aOther.value) { ++alive; }
+    ~tracked() { --alive; }
+
+    static inline int alive = 0;
+    int value;
+};
+}  // namespace
+
+TEST(ErrorTest, SmallErrorsAreInline)
+{
+    static_assert(error::is_inline<eReaderError>);
+    static_assert(error::is_inline<eBigError>);
+    static_assert(not error::is_inline<snapshot>);
+    static_assert(sizeof(error) < sizeof(snapshot));
+}
+
+TEST(ErrorTest, OneVtablePointer)
+{
+    static_assert(sizeof(error) == error::kInlineSize + sizeof(void *));
+    static_assert(error::is_trivially_relocatable<eReaderError>);
+    static_assert(error::is_trivially_relocatable<snapshot>);
+    static_assert(not error::is_trivially_relocatable<tracked>);
+}
+
+TEST(ErrorTest, MoveNonTrivialError)
+{
+    tracked::alive = 0;
+    {
+        error e(tracked{5});
+        ASSERT_EQ(tracked::alive, 1);
+        error e2(std::move(e));
+        ASSERT_EQ(tracked::alive, 1);
+        ASSERT_FALSE(e);
+        ASSERT_TRUE(e2.contains<tracked>());
+        ASSERT_EQ(e2.value<tracked>().value, 5);
+
+        e2 = error(eReaderError::kError2);
+        ASSERT_EQ(tracked::alive, 0);
+        ASSERT_TRUE(e2.contains<eReaderError>());
+        ASSERT_FALSE(e2.contains<tracked>());
+    }
+    ASSERT_EQ(tracked::alive, 0);
+}
+
+TEST(ErrorTest, LargeErrorSpills)
+{
+    snapshot s{};
+    s.words[15] = 42;
+    error e(s);
+    ASSERT_TRUE(e.contains<snapshot>());
+    ASSERT_EQ(e.value<snapshot>().words[15], 42);
+    ASSERT_EQ(e.type_name(), type_name::kName<snapshot>);
+}
+
+TEST(ErrorTest, MoveKeepsSpilledError)
+{
+    snapshot s{};
+    s.words[0] = 7;
+    error e(s);
+    const snapshot *kSpilled = &e.value<snapshot>();
+
+    error e2(std::move(e));
+    ASSERT_FALSE(e);
+    ASSERT_TRUE(e2.contains<snapshot>());
+    ASSERT_EQ(&e2.value<snapshot>(), kSpilled);
+    ASSERT_EQ(e2.value<snapshot>().words[0], 7);
+
+    e2 = error(eReaderError::kError1);
+    ASSERT_TRUE(e2.contains<eReaderError>());
+    ASSERT_EQ(e2.value<eReaderError>(), eReaderError::kError1);
+}
+
+TEST(ErrorTest, SpillResource)
+{
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::memory_resource *previous = tricky::error_spill::resource();
+    tricky::error_spill::resource(&arena);
+    {
+        error e(snapshot{});
+        tricky::error_spill::resource(previous);
+        // freed through the resource it came from
+    }
+    ASSERT_EQ(tricky::error_spill::resource(), previous);
+}
+
+TEST(ErrorTest, ExhaustedSpillResource)
+{
+    // room for one spilled snapshot only
+    alignas(std::max_align_t) std::byte buffer[sizeof(snapshot) + 64];
+    std::pmr::monotonic_buffer_resource arena(
+        buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    std::pmr::memory_resource *previous = tricky::error_spill::resource();
+    tricky::error_spill::resource(&arena);
+
+    snapshot s{};
+    s.words[3] = 3;
+    error spilled(s);
+    error failed(s);
+    tricky::error_spill::resource(previous);
+
+    ASSERT_TRUE(spilled.contains<snapshot>());
+    ASSERT_EQ(spilled.value<snapshot>().words[3], 3);
+
+    ASSERT_TRUE(failed);
+    ASSERT_FALSE(failed.contains<snapshot>());
+    ASSERT_TRUE(failed.contains<std::errc>());
+    ASSERT_EQ(failed.value<std::errc>(), std::errc::not_enough_memory);
+    ASSERT_EQ(failed.type_name(), type_name::kName<std::errc>);
+
+    error moved(std::move(failed));
+    ASSERT_EQ(moved.value<std::errc>(), std::errc::not_enough_memory);
+}
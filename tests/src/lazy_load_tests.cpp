@@ -130,3 +130,153 @@ TEST_F(LazyLoadTest, TestWithLValue)
     int k = 5;
     auto load = tricky::on_error(k);
 }
+
+TEST_F(LazyLoadTest, DeferredWithoutError)
+{
+    bool is_produced{};
+    char const* kName = "name";
+    auto make_result = [&is_produced](char const* aName)
+    {
+        auto load = tricky::on_error(tricky::defer(
+            [&is_produced, aName]() noexcept
+            {
+                is_produced = true;
+                return cseq_t(aName, std::strlen(aName));
+            }));
+        return result<void>{};
+    };
+
+    const auto r = make_result(kName);
+    ASSERT_FALSE(is_produced);
+    ASSERT_EQ(shard_state::get_const_payload().size(), 0);
+}
+
+TEST_F(LazyLoadTest, DeferredWithError)
+{
+    bool is_payload_processed{};
+    const auto payload_handlers =
+        std::make_tuple([&is_payload_processed](cseq_t) noexcept
+                        { is_payload_processed = true; });
+
+    char const* kName = "name";
+    auto make_result = [](char const* aName)
+    {
+        auto load = tricky::on_error(tricky::defer(
+            [aName]() noexcept { return cseq_t(aName, std::strlen(aName)); }));
+        return result<void>{eBufferError::kInvalidPointer};
+    };
+
+    const auto r = make_result(kName);
+    ASSERT_EQ(shard_state::get_const_payload().size(), 1);
+
+    process_result(r, payload_handlers);
+    ASSERT_TRUE(is_payload_processed);
+}
+
+TEST_F(LazyLoadTest, DeferredVoidProducerLoadsItself)
+{
+    bool is_payload_processed{};
+    const auto payload_handlers = std::make_tuple(
+        [&is_payload_processed](int aFirst, int aSecond) noexcept
+        { is_payload_processed = aFirst == 5 && aSecond == 2; });
+
+    int produced{};
+    auto make_result = [&produced]()
+    {
+        auto load = tricky::on_error(
+            tricky::defer(
+                [&produced]() noexcept
+                {
+                    ++produced;
+                    shard_state::load(5);
+                }),
+            tricky::defer([&produced]() noexcept { return ++produced; }));
+        return result<void>{eBufferError::kInvalidIndex};
+    };
+
+    const auto r = make_result();
+    ASSERT_EQ(produced, 2);
+    ASSERT_EQ(shard_state::get_const_payload().size(), 2);
+
+    process_result(r, payload_handlers);
+    ASSERT_TRUE(is_payload_processed);
+}
+
+TEST_F(LazyLoadTest, DeferredMoved)
+{
+    bool is_produced{};
+    const auto producer = [&is_produced]() noexcept
+    {
+        is_produced = true;
+        return 1;
+    };
+    static_assert(std::is_same_v<
+                  decltype(tricky::on_error(tricky::defer(producer))),
+                  tricky::lazy_load<tricky::deferred<
+                      utils::remove_cvref_t<decltype(producer)>>>>);
+
+    auto make_result = [&producer]()
+    {
+        auto load = tricky::on_error(tricky::defer(producer));
+        return std::make_tuple(result<void>{eBufferError::kInvalidPointer},
+                               std::move(load));
+    };
+
+    {
+        auto [r, load] = make_result();
+        ASSERT_FALSE(is_produced);
+        ASSERT_EQ(shard_state::get_const_payload().size(), 0);
+
+        process_result(r, std::make_tuple([](int) noexcept {}));
+    }
+    ASSERT_FALSE(is_produced);
+}
+
+TEST_F(LazyLoadTest, DeferredMixedWithValues)
+{
+    bool is_payload_processed{};
+    const auto payload_handlers = std::make_tuple(
+        [&is_payload_processed](int aId, float aRatio) noexcept
+        { is_payload_processed = aId == 7 && aRatio == 2.5f; });
+
+    int produced{};
+    auto make_result = [&produced](bool aFail)
+    {
+        auto load = tricky::on_error(7, tricky::defer(
+                                            [&produced]() noexcept
+                                            {
+                                                ++produced;
+                                                return 2.5f;
+                                            }));
+        return aFail ? result<void>{eBufferError::kInvalidIndex}
+                     : result<void>{};
+    };
+
+    const auto ok = make_result(false);
+    ASSERT_EQ(produced, 0);
+    ASSERT_EQ(shard_state::get_const_payload().size(), 0);
+
+    const auto r = make_result(true);
+    ASSERT_EQ(produced, 1);
+    ASSERT_EQ(shard_state::get_const_payload().size(), 2);
+
+    process_result(r, payload_handlers);
+    ASSERT_TRUE(is_payload_processed);
+}
+
+TEST_F(LazyLoadTest, CallableIsLoadedAsValue)
+{
+    static int called{};
+    using producer_t = int (*)() noexcept;
+    const producer_t producer = []() noexcept { return ++called; };
+
+    auto make_result = [producer]()
+    {
+        auto load = tricky::on_error(producer);
+        return result<void>{eBufferError::kInvalidPointer};
+    };
+
+    const auto r = make_result();
+    ASSERT_EQ(called, 0);
+    ASSERT_EQ(shard_state::get_const_payload().size(), 1);
+}
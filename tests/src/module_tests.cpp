@@ -0,0 +1,121 @@
+// Smoke test of the C++20 module: the public API of the headers must be
+// reachable through `import tricky;` alone. A name added to a header goes to
+// the list below too, so that a missing export fails to compile here.
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+import tricky;
+
+namespace exported
+{
+// results
+using tricky::basic_result;
+using tricky::inline_result;
+using tricky::is_result;
+using tricky::is_result_v;
+using tricky::niche_traits;
+using tricky::niche_traits_v;
+using tricky::process_payload;
+using tricky::result;
+
+// handlers
+using tricky::any_handler;
+using tricky::categories_handler;
+using tricky::handler;
+using tricky::handlers;
+using tricky::is_any_handler;
+using tricky::is_any_handler_v;
+using tricky::is_categories_handler;
+using tricky::is_categories_handler_v;
+using tricky::is_handlers;
+using tricky::is_handlers_v;
+using tricky::is_values_handler;
+using tricky::is_values_handler_v;
+using tricky::try_handle_all;
+using tricky::try_handle_some;
+using tricky::values_handler;
+
+// error state and payloads
+using tricky::defer;
+using tricky::deferred;
+using tricky::e_source_location;
+using tricky::kPayloadArena;
+using tricky::kPayloadArenaChunk;
+using tricky::kPayloadMaxSpace;
+using tricky::kPayloadStats;
+using tricky::kSwitchableState;
+using tricky::kThreadLocalState;
+using tricky::lazy_load;
+using tricky::on_error;
+using tricky::payload_arena;
+using tricky::payload_stats;
+using tricky::shared_state;
+
+// telemetry
+using tricky::error_record;
+using tricky::error_telemetry;
+using tricky::kErrorTelemetry;
+using tricky::kErrorTelemetryCapacity;
+
+// contexts
+using tricky::context;
+using tricky::context_activator;
+using tricky::context_pool;
+using tricky::error;
+using tricky::error_spill;
+using tricky::heavy_context;
+using tricky::is_context;
+using tricky::is_context_v;
+using tricky::kContextPoolPayloadSize;
+using tricky::kErrorInlineSize;
+using tricky::polymorphic_context;
+
+// batches and scans
+using tricky::best_scan_isa;
+using tricky::compress_values;
+using tricky::contains_error;
+using tricky::count_indices;
+using tricky::find_first_error;
+using tricky::kScanRuntimeDispatch;
+using tricky::result_batch;
+using tricky::scan_isa;
+using tricky::scan_isa_supported;
+
+#ifdef TRICKY_COROUTINES
+// coroutines
+using tricky::sync_wait;
+using tricky::task;
+#endif
+}  // namespace exported
+
+namespace
+{
+enum class eSmokeError : std::uint8_t
+{
+    kFirst,
+    kSecond
+};
+
+template <typename T>
+using result = tricky::result<T, eSmokeError>;
+}  // namespace
+
+TEST(ModuleTest, TryHandleAll)
+{
+    const int value = tricky::try_handle_all(
+        []() noexcept { return result<int>{eSmokeError::kSecond}; },
+        tricky::handlers(tricky::handler([](auto) noexcept { return -1; })));
+    ASSERT_EQ(value, -1);
+    ASSERT_FALSE(tricky::shared_state::has_error());
+}
+
+TEST(ModuleTest, TryHandleSome)
+{
+    auto r = tricky::try_handle_some(
+        []() noexcept { return result<int>{eSmokeError::kFirst}; },
+        tricky::handlers(tricky::handler<eSmokeError::kFirst>(
+            [](auto) noexcept { return result<int>{1}; })));
+    ASSERT_TRUE(r);
+    ASSERT_EQ(r.value(), 1);
+}
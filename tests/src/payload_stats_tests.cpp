@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <tricky/tricky.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "test_common.h"
+
+namespace
+{
+using namespace test_utils;
+using cseq_t = cargo::seq<const char, std::size_t>;
+
+static_assert(tricky::kPayloadStats,
+              "payload_stats_tests must be built with TRICKY_PAYLOAD_STATS");
+
+struct oversized
+{
+    std::array<char, tricky::kPayloadMaxSpace + 1> bytes;
+};
+
+class PayloadStatsTest : public ::testing::Test
+{
+   protected:
+    void SetUp() override { tricky::shared_state::clear_payload_stats(); }
+    void TearDown() override { tricky::shared_state::reset(); }
+};
+}  // namespace
+
+TEST_F(PayloadStatsTest, CountsLoadsAndBytes)
+{
+    result<int> r{eFileError::kEOF, std::uint32_t{1}, 'c'};
+
+    const auto stats = tricky::shared_state::get_payload_stats();
+    ASSERT_EQ(stats.loads, 2);
+    ASSERT_EQ(stats.rejected_loads, 0);
+    const std::size_t used = tricky::shared_state::get_payload().size();
+    ASSERT_GE(used, sizeof(std::uint32_t) + sizeof(char));
+    ASSERT_EQ(stats.bytes_loaded, used);
+    ASSERT_EQ(stats.bytes_rejected, 0);
+    ASSERT_EQ(stats.high_water_mark, used);
+}
+
+TEST_F(PayloadStatsTest, CountsRejectedBytes)
+{
+    result<int> r{eFileError::kEOF, 'c', oversized{}};
+
+    const auto stats = tricky::shared_state::get_payload_stats();
+    ASSERT_EQ(stats.loads, 2);
+    ASSERT_EQ(stats.rejected_loads, 1);
+    ASSERT_EQ(stats.bytes_loaded,
+              tricky::shared_state::get_payload().size());
+    ASSERT_GE(stats.bytes_rejected, sizeof(oversized));
+}
+
+TEST_F(PayloadStatsTest, HighWaterMarkIsPerPayload)
+{
+    std::size_t one{};
+    for (int i = 0; i < 3; ++i)
+    {
+        result<int> r{eReaderError::kError1, i};
+        one = tricky::shared_state::get_payload().size();
+        tricky::shared_state::reset();
+    }
+    std::size_t two{};
+    {
+        result<int> r{eReaderError::kError1, 1, 2};
+        two = tricky::shared_state::get_payload().size();
+        tricky::shared_state::reset();
+    }
+
+    const auto stats = tricky::shared_state::get_payload_stats();
+    ASSERT_EQ(stats.loads, 5);
+    ASSERT_EQ(stats.bytes_loaded, 3 * one + two);
+    ASSERT_EQ(stats.high_water_mark, two);
+}
+
+TEST_F(PayloadStatsTest, CountsLazyLoads)
+{
+    const auto make_result = []() noexcept
+    {
+        auto load = tricky::on_error(std::uint64_t{7}, oversized{});
+        return result<void>{eBufferError::kInvalidIndex};
+    };
+    const auto r = make_result();
+
+    const auto stats = tricky::shared_state::get_payload_stats();
+    ASSERT_EQ(stats.loads, 2);
+    ASSERT_EQ(stats.bytes_loaded,
+              tricky::shared_state::get_payload().size());
+    ASSERT_GE(stats.bytes_rejected, sizeof(oversized));
+}
+
+TEST_F(PayloadStatsTest, CountsSequenceBytes)
+{
+    const char *fileName = "payload_stats_tests.cpp";
+    result<int> r{eFileError::kEOF, cseq_t(fileName, std::strlen(fileName))};
+
+    const auto stats = tricky::shared_state::get_payload_stats();
+    const std::size_t used = tricky::shared_state::get_payload().size();
+    ASSERT_EQ(stats.loads, 1);
+    ASSERT_GE(used, std::strlen(fileName));
+    ASSERT_EQ(stats.bytes_loaded, used);
+    ASSERT_EQ(stats.high_water_mark, used);
+}
+
+TEST_F(PayloadStatsTest, CountsRejectedSequenceBytes)
+{
+    const std::string name(tricky::kPayloadMaxSpace + 1, 'x');
+    result<int> r{eFileError::kEOF, cseq_t(name.data(), name.size())};
+
+    const auto stats = tricky::shared_state::get_payload_stats();
+    ASSERT_EQ(stats.rejected_loads, 1);
+    ASSERT_GE(stats.bytes_rejected, name.size());
+}
+
+TEST_F(PayloadStatsTest, Clear)
+{
+    result<int> r{eFileError::kEOF, 1};
+    tricky::shared_state::clear_payload_stats();
+
+    const auto stats = tricky::shared_state::get_payload_stats();
+    ASSERT_EQ(stats.loads, 0);
+    ASSERT_EQ(stats.bytes_loaded, 0);
+    ASSERT_EQ(stats.high_water_mark, 0);
+}
@@ -0,0 +1,219 @@
+// Built twice: scan_tests picks the kernels at compile time,
+// scan_dispatch_tests (TRICKY_SCAN_RUNTIME_DISPATCH) at run time.
+#include <gtest/gtest.h>
+#include <tricky/batch.h>
+#include <tricky/scan.h>
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "test_common.h"
+
+namespace
+{
+using namespace test_utils;
+
+using tricky::scan_isa;
+
+// sizes around the block widths of every kernel
+const std::vector<std::size_t> kSizes = {0,  1,  15,  16,  17,  31,   32,
+                                         33, 63, 64,  65,  127, 128,  129,
+                                         255, 1000, 8160, 8161, 20000};
+
+std::vector<std::uint8_t> random_indices(std::size_t aSize,
+                                         std::uint8_t aCount,
+                                         unsigned aErrorPercent)
+{
+    std::mt19937 engine(static_cast<std::mt19937::result_type>(aSize));
+    std::uniform_int_distribution<unsigned> percent(0, 99);
+    std::uniform_int_distribution<unsigned> error(1, aCount - 1u);
+    std::vector<std::uint8_t> indices(aSize);
+    for (auto &index: indices)
+    {
+        index = percent(engine) < aErrorPercent
+                    ? static_cast<std::uint8_t>(error(engine))
+                    : std::uint8_t{};
+    }
+    return indices;
+}
+
+class ScanTest : public ::testing::TestWithParam<scan_isa>
+{
+   protected:
+    void SetUp() override
+    {
+        if (!tricky::scan_isa_supported(GetParam()))
+        {
+            GTEST_SKIP() << "scan_isa is not supported";
+        }
+    }
+};
+}  // namespace
+
+TEST(ScanIsaTest, BestIsSupported)
+{
+    ASSERT_TRUE(tricky::scan_isa_supported(scan_isa::kScalar));
+    ASSERT_TRUE(tricky::scan_isa_supported(tricky::best_scan_isa()));
+}
+
+TEST_P(ScanTest, ContainsError)
+{
+    for (const std::size_t size: kSizes)
+    {
+        std::vector<std::uint8_t> indices(size);
+        ASSERT_FALSE(tricky::contains_error(indices.data(), size, GetParam()));
+        for (std::size_t i = 0; i < size; i += 1 + i / 8)
+        {
+            indices[i] = 3;
+            ASSERT_TRUE(
+                tricky::contains_error(indices.data(), size, GetParam()))
+                << "size " << size << ", error at " << i;
+            indices[i] = 0;
+        }
+    }
+}
+
+TEST_P(ScanTest, FindFirstError)
+{
+    for (const std::size_t size: kSizes)
+    {
+        std::vector<std::uint8_t> indices(size);
+        ASSERT_EQ(tricky::find_first_error(indices.data(), size, GetParam()),
+                  size);
+        for (std::size_t i = size; i-- > 0; i -= i / 8)
+        {
+            indices[i] = 1;
+            ASSERT_EQ(
+                tricky::find_first_error(indices.data(), size, GetParam()), i);
+        }
+    }
+}
+
+TEST_P(ScanTest, CountIndices)
+{
+    for (const std::size_t size: kSizes)
+    {
+        const auto indices = random_indices(size, 5, 30);
+        std::array<std::size_t, 5> expected{};
+        for (const auto index: indices)
+        {
+            ++expected[index];
+        }
+        ASSERT_EQ(
+            tricky::count_indices<5>(indices.data(), size, GetParam()),
+            expected)
+            << "size " << size;
+    }
+}
+
+TEST_P(ScanTest, CountManyIndices)
+{
+    const auto indices = random_indices(1000, 40, 50);
+    std::array<std::size_t, 40> expected{};
+    for (const auto index: indices)
+    {
+        ++expected[index];
+    }
+    ASSERT_EQ(
+        tricky::count_indices<40>(indices.data(), indices.size(), GetParam()),
+        expected);
+}
+
+TEST_P(ScanTest, CompressValues)
+{
+    for (const unsigned percent: {0u, 3u, 50u, 100u})
+    {
+        for (const std::size_t size: kSizes)
+        {
+            const auto indices = random_indices(size, 3, percent);
+            std::vector<std::int32_t> values(size);
+            std::vector<std::int32_t> expected;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                values[i] = static_cast<std::int32_t>(i);
+                if (!indices[i])
+                {
+                    expected.push_back(values[i]);
+                }
+            }
+            std::vector<std::int32_t> out(size);
+            out.resize(tricky::compress_values(values.data(), indices.data(),
+                                               size, out.data(), GetParam()));
+            ASSERT_EQ(out, expected)
+                << "size " << size << ", " << percent << "% errors";
+        }
+    }
+}
+
+TEST_P(ScanTest, CompressNonTrivialValues)
+{
+    const auto indices = random_indices(100, 2, 40);
+    std::vector<std::string> values;
+    std::vector<std::string> expected;
+    for (std::size_t i = 0; i < indices.size(); ++i)
+    {
+        values.push_back(std::string(20, static_cast<char>('a' + i % 26)));
+        if (!indices[i])
+        {
+            expected.push_back(values.back());
+        }
+    }
+    std::vector<std::string> out(values.size());
+    out.resize(tricky::compress_values(values.data(), indices.data(),
+                                       values.size(), out.data(), GetParam()));
+    ASSERT_EQ(out, expected);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllIsa, ScanTest,
+                         ::testing::Values(scan_isa::kScalar, scan_isa::kSSE2,
+                                           scan_isa::kAVX2));
+
+TEST(ScanIndicesTest, Wide)
+{
+    const std::vector<std::uint16_t> indices = {0, 0, 300, 0, 2, 0};
+    ASSERT_TRUE(tricky::contains_error(indices.data(), indices.size()));
+    ASSERT_EQ(tricky::find_first_error(indices.data(), indices.size()), 2);
+    const auto counts =
+        tricky::count_indices<301>(indices.data(), indices.size());
+    ASSERT_EQ(counts[0], 4);
+    ASSERT_EQ(counts[2], 1);
+    ASSERT_EQ(counts[300], 1);
+}
+
+TEST(ScanBatchTest, CountAndCompress)
+{
+    tricky::result_batch<int, eReaderError, eFileError> b;
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i % 7 == 3)
+        {
+            b.push_error(eFileError::kEOF);
+        }
+        else if (i % 11 == 5)
+        {
+            b.push_error(eReaderError::kError1);
+        }
+        else
+        {
+            b.push_value(i);
+        }
+    }
+
+    const auto counts = b.error_counts();
+    ASSERT_EQ(counts[1] + counts[2], b.error_count());
+    ASSERT_EQ(counts[0], b.size() - b.error_count());
+    ASSERT_EQ(counts[2], 14);
+
+    std::vector<int> values(b.size());
+    values.resize(
+        static_cast<std::size_t>(b.compress_values(values.data()) -
+                                 values.data()));
+    ASSERT_EQ(values.size(), counts[0]);
+    for (const int value: values)
+    {
+        ASSERT_FALSE(value % 7 == 3 || value % 11 == 5);
+    }
+}
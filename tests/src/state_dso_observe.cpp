@@ -0,0 +1,18 @@
+#include "state_dso.h"
+
+namespace state_dso
+{
+bool observed_error() noexcept { return tricky::shared_state::has_error(); }
+
+std::size_t observed_type_index() noexcept
+{
+    return tricky::shared_state::type_index();
+}
+
+const void *observe_side_payload() noexcept
+{
+    return &tricky::shared_state::get_const_payload();
+}
+
+void handle_error() noexcept { tricky::shared_state::reset(); }
+}  // namespace state_dso
@@ -0,0 +1,18 @@
+#include "state_dso.h"
+
+namespace state_dso
+{
+test_utils::result<int> read(int aValue) noexcept
+{
+    if (aValue < 0)
+    {
+        return {test_utils::eFileError::kEOF, aValue};
+    }
+    return aValue;
+}
+
+const void *raise_side_payload() noexcept
+{
+    return &tricky::shared_state::get_const_payload();
+}
+}  // namespace state_dso
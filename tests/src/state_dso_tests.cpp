@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include <tricky/tricky.h>
+
+#include "state_dso.h"
+
+namespace
+{
+using namespace test_utils;
+}  // namespace
+
+TEST(StateDsoTest, OneStateForEveryModule)
+{
+    const void *kPayload = &tricky::shared_state::get_const_payload();
+    ASSERT_EQ(state_dso::raise_side_payload(), kPayload);
+    ASSERT_EQ(state_dso::observe_side_payload(), kPayload);
+}
+
+TEST(StateDsoTest, ErrorRaisedInOneLibraryIsSeenInAnother)
+{
+    ASSERT_FALSE(state_dso::observed_error());
+    const auto r = state_dso::read(-1);
+    ASSERT_TRUE(state_dso::observed_error());
+    ASSERT_TRUE(tricky::shared_state::has_error());
+    ASSERT_EQ(state_dso::observed_type_index(), r.type_index());
+    ASSERT_EQ(r.error<eFileError>(), eFileError::kEOF);
+
+    state_dso::handle_error();
+    ASSERT_FALSE(tricky::shared_state::has_error());
+}
+
+TEST(StateDsoTest, ValueLeavesStateClear)
+{
+    const auto r = state_dso::read(7);
+    ASSERT_FALSE(state_dso::observed_error());
+    ASSERT_EQ(r.value(), 7);
+}
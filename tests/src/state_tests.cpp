@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <tricky/tricky.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test_common.h"
+
+namespace
+{
+using namespace test_utils;
+
+static_assert(tricky::shared_state::is_thread_local,
+              "state_tests must be built with TRICKY_THREAD_LOCAL_STATE");
+
+constexpr std::size_t kThreadCount = 8;
+constexpr std::size_t kIterations = 10000;
+
+// Spins until every participant reached the same point.
+class spin_barrier
+{
+   public:
+    explicit spin_barrier(std::size_t aCount) noexcept : count_(aCount) {}
+
+    void arrive_and_wait() noexcept
+    {
+        const std::size_t kGeneration = generation_.load();
+        if (arrived_.fetch_add(1) + 1 == count_)
+        {
+            arrived_.store(0);
+            generation_.fetch_add(1);
+        }
+        else
+        {
+            while (generation_.load() == kGeneration)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+   private:
+    const std::size_t count_;
+    std::atomic<std::size_t> arrived_{};
+    std::atomic<std::size_t> generation_{};
+};
+
+const auto handle_any = tricky::handlers(tricky::handler(
+    [](auto aError) noexcept { return static_cast<int>(aError); }));
+}  // namespace
+
+TEST(StateTest, NewThreadStartsWithoutError)
+{
+    result<int> r{eFileError::kPermission};
+    ASSERT_TRUE(tricky::shared_state::has_error());
+
+    bool has_error_in_other_thread{true};
+    std::thread([&has_error_in_other_thread]() {
+        has_error_in_other_thread = tricky::shared_state::has_error();
+    }).join();
+
+    ASSERT_FALSE(has_error_in_other_thread);
+    handle_any(std::move(r));
+    ASSERT_FALSE(tricky::shared_state::has_error());
+}
+
+TEST(StateTest, ErrorsDoNotLeakBetweenThreads)
+{
+    spin_barrier barrier(kThreadCount);
+    std::atomic<std::size_t> failures{};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < kThreadCount; ++t)
+    {
+        threads.emplace_back(
+            [t, &barrier, &failures]()
+            {
+                const bool kIsFailing = t % 2;
+                // every thread sets up its own state before anyone checks it
+                result<int> r = kIsFailing ? result<int>{eFileError::kEOF,
+                                                         static_cast<int>(t)}
+                                           : result<int>{static_cast<int>(t)};
+                barrier.arrive_and_wait();
+                if (r.has_error() != kIsFailing)
+                {
+                    ++failures;
+                }
+                if (kIsFailing && !r.is_active_type<eFileError>())
+                {
+                    ++failures;
+                }
+                barrier.arrive_and_wait();
+                handle_any(std::move(r));
+            });
+    }
+    for (auto &thread: threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+}
+
+TEST(StateTest, ConcurrentStress)
+{
+    std::atomic<std::size_t> failures{};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < kThreadCount; ++t)
+    {
+        threads.emplace_back(
+            [t, &failures]()
+            {
+                for (std::size_t i = 0; i < kIterations; ++i)
+                {
+                    const bool kIsFailing = (i + t) % 3 == 0;
+                    auto r = kIsFailing ? result<int>{eWriterError::kError4}
+                                        : result<int>{static_cast<int>(i)};
+                    const int kExpected =
+                        kIsFailing ? utils::to_underlying(eWriterError::kError4)
+                                   : static_cast<int>(i);
+                    if (handle_any(std::move(r)) != kExpected ||
+                        tricky::shared_state::has_error())
+                    {
+                        ++failures;
+                    }
+                }
+            });
+    }
+    for (auto &thread: threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+}
@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <tricky/batch.h>
+#include <tricky/tricky.h>
+
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "test_common.h"
+
+namespace
+{
+using namespace test_utils;
+
+static_assert(tricky::error_telemetry::enabled,
+              "telemetry_tests must be built with TRICKY_ERROR_TELEMETRY");
+static_assert(tricky::error_telemetry::capacity == 8);
+
+constexpr std::size_t kCapacity = tricky::error_telemetry::capacity;
+constexpr std::size_t kThreadCount = 4;
+constexpr std::size_t kIterations = 20000;
+
+using big_result = tricky::result<int, eBigError>;
+
+std::vector<tricky::error_record> drain_all()
+{
+    std::vector<tricky::error_record> records;
+    tricky::error_telemetry::drain(
+        [&records](const tricky::error_record &aRecord)
+        { records.push_back(aRecord); });
+    return records;
+}
+
+class TelemetryTest : public ::testing::Test
+{
+   protected:
+    void SetUp() override { drain_all(); }
+    void TearDown() override { tricky::shared_state::reset(); }
+};
+}  // namespace
+
+TEST_F(TelemetryTest, RecordsCategoryValueAndLocation)
+{
+    const auto kBefore = tricky::error_record::clock::now();
+    const int kLine = __LINE__ + 1;
+    result<int> r = TRICKY_NEW_ERROR(eFileError::kAccessDenied);
+    const auto kAfter = tricky::error_record::clock::now();
+
+    const auto records = drain_all();
+    ASSERT_EQ(records.size(), 1);
+    const tricky::error_record &record = records.front();
+    ASSERT_EQ(record.category, type_name::kName<eFileError>);
+    ASSERT_EQ(record.value,
+              utils::to_underlying(eFileError::kAccessDenied));
+    ASSERT_TRUE(record.has_location());
+    ASSERT_EQ(record.location().line(), kLine);
+    ASSERT_STREQ(record.location().file(), __FILE__);
+    ASSERT_GE(record.time, kBefore);
+    ASSERT_LE(record.time, kAfter);
+}
+
+TEST_F(TelemetryTest, RecordWithoutLocation)
+{
+    result<int> r{eReaderError::kError2, 42};
+
+    const auto records = drain_all();
+    ASSERT_EQ(records.size(), 1);
+    ASSERT_EQ(records.front().category, type_name::kName<eReaderError>);
+    ASSERT_EQ(records.front().value,
+              utils::to_underlying(eReaderError::kError2));
+    ASSERT_FALSE(records.front().has_location());
+}
+
+TEST_F(TelemetryTest, DrainedRecordsAreNotRepeated)
+{
+    result<void> r{eWriterError::kError4};
+    tricky::shared_state::reset();
+    ASSERT_EQ(drain_all().size(), 1);
+    ASSERT_EQ(drain_all().size(), 0);
+}
+
+TEST_F(TelemetryTest, LanesOfBatchAreNotRecorded)
+{
+    tricky::result_batch<int, eReaderError, eFileError> b;
+    b.push_value(1);
+    b.push_error(eFileError::kEOF);
+    b.push_error(eReaderError::kError1);
+
+    const auto to_int =
+        tricky::handlers(tricky::handler([](auto) noexcept { return -1; }));
+    ASSERT_TRUE(b[1].has_error());
+    std::vector<int> out;
+    b.handle_all(to_int, std::back_inserter(out));
+    b.for_each([](std::size_t, int) {}, to_int);
+    ASSERT_EQ(out, (std::vector<int>{1, -1, -1}));
+    ASSERT_TRUE(drain_all().empty());
+}
+
+TEST_F(TelemetryTest, KeepsNewestRecords)
+{
+    constexpr std::size_t kCount = 2 * kCapacity + 3;
+    const std::uint64_t kLost = tricky::error_telemetry::lost();
+    for (std::size_t i = 0; i < kCount; ++i)
+    {
+        big_result r{static_cast<eBigError>(i)};
+        tricky::shared_state::reset();
+    }
+
+    const auto records = drain_all();
+    ASSERT_EQ(records.size(), kCapacity);
+    for (std::size_t i = 0; i < kCapacity; ++i)
+    {
+        ASSERT_EQ(records[i].value,
+                  static_cast<std::int64_t>(kCount - kCapacity + i));
+    }
+    ASSERT_EQ(tricky::error_telemetry::lost() - kLost, kCount - kCapacity);
+}
+
+TEST_F(TelemetryTest, RecordsOfExitedThreadAreDrained)
+{
+    std::thread(
+        []()
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                result<int> r{eBufferError::kInvalidPointer};
+                tricky::shared_state::reset();
+            }
+        })
+        .join();
+
+    const auto records = drain_all();
+    ASSERT_EQ(records.size(), 3);
+    for (const auto &record: records)
+    {
+        ASSERT_EQ(record.category, type_name::kName<eBufferError>);
+    }
+}
+
+TEST_F(TelemetryTest, ErrorRaisedDuringThreadExitIsDropped)
+{
+    struct raises_on_exit
+    {
+        ~raises_on_exit()
+        {
+            result<int> r{eFileError::kEOF};
+            tricky::shared_state::reset();
+        }
+    };
+
+    const std::uint64_t kLost = tricky::error_telemetry::lost();
+    std::thread(
+        []()
+        {
+            // constructed before the ring owner, so destroyed after it;
+            // the state is constructed first and outlives both
+            tricky::shared_state::reset();
+            thread_local raises_on_exit last;
+            result<int> r{eReaderError::kError1};
+            tricky::shared_state::reset();
+        })
+        .join();
+
+    const auto records = drain_all();
+    ASSERT_EQ(records.size(), 1);
+    ASSERT_EQ(records.front().category, type_name::kName<eReaderError>);
+    ASSERT_EQ(tricky::error_telemetry::lost() - kLost, 1);
+}
+
+TEST_F(TelemetryTest, CollectorRunsConcurrentlyWithProducers)
+{
+    const std::uint64_t kLost = tricky::error_telemetry::lost();
+    std::atomic<bool> done{};
+    std::atomic<std::size_t> failures{};
+    std::size_t drained = 0;
+    std::vector<std::int64_t> last(kThreadCount, -1);
+    const auto collect = [&](const tricky::error_record &aRecord)
+    {
+        ++drained;
+        // values of every producer must be seen in increasing order
+        const auto kThread = static_cast<std::size_t>(aRecord.value) /
+                             kIterations;
+        if (kThread >= kThreadCount || aRecord.value <= last[kThread])
+        {
+            ++failures;
+            return;
+        }
+        last[kThread] = aRecord.value;
+    };
+
+    std::thread collector(
+        [&]()
+        {
+            while (!done.load())
+            {
+                tricky::error_telemetry::drain(collect);
+            }
+        });
+    std::vector<std::thread> producers;
+    for (std::size_t t = 0; t < kThreadCount; ++t)
+    {
+        producers.emplace_back(
+            [t]()
+            {
+                for (std::size_t i = 0; i < kIterations; ++i)
+                {
+                    big_result r{static_cast<eBigError>(t * kIterations + i)};
+                    tricky::shared_state::reset();
+                }
+            });
+    }
+    for (auto &producer: producers)
+    {
+        producer.join();
+    }
+    done.store(true);
+    collector.join();
+    tricky::error_telemetry::drain(collect);
+
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_EQ(drained + (tricky::error_telemetry::lost() - kLost),
+              kThreadCount * kIterations);
+}
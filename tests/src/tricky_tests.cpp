@@ -2,6 +2,9 @@
 #include <tricky/tricky.h>
 #include <user_literals/user_literals.h>
 
+#include <limits>
+#include <vector>
+
 #include "test_common.h"
 
 namespace
@@ -871,3 +874,400 @@ TEST(TrickySimpleTest, TryHandleSome2)
     ASSERT_EQ(res.value(), 3);
     ASSERT_EQ(file_error, eFileError::kFileNotFound);
 }
+
+namespace
+{
+template <typename T>
+using inline_result = tricky::inline_result<T, eReaderError, eWriterError,
+                                            eBufferError, eFileError>;
+
+inline_result<int> parse_inline(int aValue) noexcept
+{
+    if (aValue < 0)
+    {
+        return eBufferError::kInvalidIndex;
+    }
+    return aValue;
+}
+
+inline_result<int> parse_inline_twice(int aValue) noexcept
+{
+    TRICKY_AUTO(v, parse_inline(aValue));
+    return v * 2;
+}
+}  // namespace
+
+TEST(InlineResultTest, StaticChecks)
+{
+    static_assert(tricky::is_result_v<inline_result<int>>);
+    static_assert(tricky::is_result_v<inline_result<void>>);
+    static_assert(sizeof(inline_result<std::uint32_t>) ==
+                  2 * sizeof(std::uint32_t));
+    static_assert(sizeof(inline_result<void>) == 2);
+    static_assert(std::is_same_v<inline_result<int>::layout,
+                                 tricky::details::inline_layout>);
+}
+
+TEST(InlineResultTest, ConstructorWithValue)
+{
+    constexpr inline_result<int> r(-5);
+    static_assert(r.has_value());
+    static_assert(r.type_index() == 0);
+    ASSERT_TRUE(r);
+    ASSERT_EQ(r.value(), -5);
+}
+
+TEST(InlineResultTest, ConstructorWithError)
+{
+    const inline_result<int> r{eWriterError::kError5};
+    ASSERT_FALSE(r);
+    ASSERT_TRUE(r.has_error());
+    ASSERT_TRUE(r.is_active_type<eWriterError>());
+    ASSERT_EQ(r.error<eWriterError>(), eWriterError::kError5);
+    ASSERT_FALSE(tricky::shared_state::has_error());
+}
+
+TEST(InlineResultTest, ResultsAreIndependent)
+{
+    std::vector<inline_result<int>> results;
+    results.emplace_back(1);
+    results.emplace_back(eFileError::kEOF);
+    results.emplace_back(eReaderError::kError2);
+    results.emplace_back(4);
+
+    ASSERT_TRUE(results[0]);
+    ASSERT_EQ(results[0].value(), 1);
+    ASSERT_TRUE(results[1].is_active_type<eFileError>());
+    ASSERT_EQ(results[1].error<eFileError>(), eFileError::kEOF);
+    ASSERT_TRUE(results[2].is_active_type<eReaderError>());
+    ASSERT_EQ(results[2].error<eReaderError>(), eReaderError::kError2);
+    ASSERT_TRUE(results[3]);
+    ASSERT_EQ(results[3].value(), 4);
+    ASSERT_FALSE(tricky::shared_state::has_error());
+
+    const auto copy = results[1];
+    ASSERT_TRUE(copy.is_active_type<eFileError>());
+    ASSERT_EQ(copy.error<eFileError>(), eFileError::kEOF);
+}
+
+TEST(InlineResultTest, Conversion)
+{
+    tricky::inline_result<void, eFileError> r{eFileError::kPermission};
+    inline_result<char> r2(std::move(r));
+    ASSERT_TRUE(r2.has_error());
+    ASSERT_TRUE(r2.is_active_type<eFileError>());
+    ASSERT_EQ(r2.error<eFileError>(), eFileError::kPermission);
+
+    tricky::inline_result<int, eFileError> r3{7};
+    inline_result<int> r4(std::move(r3));
+    ASSERT_TRUE(r4);
+    ASSERT_EQ(r4.value(), 7);
+}
+
+TEST(InlineResultTest, Propagation)
+{
+    const auto ok = parse_inline_twice(21);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(ok.value(), 42);
+
+    const auto failed = parse_inline_twice(-1);
+    ASSERT_TRUE(failed.is_active_type<eBufferError>());
+    ASSERT_EQ(failed.error<eBufferError>(), eBufferError::kInvalidIndex);
+}
+
+TEST(InlineResultTest, Handlers)
+{
+    bool is_category_handled{};
+    const auto process_error = tricky::handlers(
+        tricky::handler<eBufferError>(
+            [&is_category_handled](auto) noexcept
+            {
+                is_category_handled = true;
+                return -1;
+            }),
+        tricky::handler([](auto) noexcept { return -2; }));
+
+    ASSERT_EQ(process_error(parse_inline_twice(3)), 6);
+    ASSERT_EQ(process_error(parse_inline_twice(-3)), -1);
+    ASSERT_TRUE(is_category_handled);
+    ASSERT_EQ(process_error(inline_result<int>{eFileError::kEOF}), -2);
+    ASSERT_EQ(tricky::shared_state::get_const_payload().size(), 0);
+}
+
+TEST(InlineResultTest, HandlersKeepPendingSharedError)
+{
+    result<int> pending{eFileError::kPermission, 'j'};
+    const std::size_t payload_size =
+        tricky::shared_state::get_const_payload().size();
+    ASSERT_NE(payload_size, 0);
+
+    const auto process_error = tricky::handlers(
+        tricky::handler<eFileError::kEOF>([](auto) noexcept { return -1; }),
+        tricky::handler<eBufferError>([](auto) noexcept { return -2; }),
+        tricky::handler([](auto) noexcept { return -3; }));
+
+    inline_result<int> located = TRICKY_NEW_ERROR(eFileError::kEOF);
+    ASSERT_EQ(process_error(std::move(located)), -1);
+    ASSERT_EQ(process_error(parse_inline_twice(-1)), -2);
+    ASSERT_EQ(process_error(inline_result<int>{eReaderError::kError2}), -3);
+
+    ASSERT_TRUE(tricky::shared_state::has_error());
+    ASSERT_TRUE(pending.is_active_type<eFileError>());
+    ASSERT_EQ(pending.error<eFileError>(), eFileError::kPermission);
+    ASSERT_EQ(tricky::shared_state::get_const_payload().size(), payload_size);
+
+    ASSERT_EQ(process_error(std::move(pending)), -3);
+    ASSERT_FALSE(tricky::shared_state::has_error());
+    ASSERT_EQ(tricky::shared_state::get_const_payload().size(), 0);
+}
+
+namespace
+{
+// Identifiers are always even, so the lowest bit of the first byte is free.
+struct even_id
+{
+    std::uint16_t value;
+};
+}  // namespace
+
+template <>
+struct tricky::niche_traits<even_id>
+    : std::bool_constant<tricky::details::kIsLittleEndian>
+{
+};
+
+namespace
+{
+template <typename T>
+using niche_result = tricky::inline_result<T, eReaderError, eWriterError>;
+
+niche_result<const int *> find_even(const std::vector<int> &aValues) noexcept
+{
+    for (const auto &value: aValues)
+    {
+        if (value % 2 == 0)
+        {
+            return &value;
+        }
+    }
+    return eReaderError::kError2;
+}
+}  // namespace
+
+TEST(NicheResultTest, StaticChecks)
+{
+    static_assert(sizeof(test_utils::result<std::uint32_t>) ==
+                  sizeof(std::uint32_t));
+    static_assert(sizeof(tricky::result<std::uint8_t, eReaderError>) == 1);
+    static_assert(sizeof(tricky::result<void, eReaderError>) == 1);
+    static_assert(sizeof(tricky::result<std::uint64_t, eBigError>) == 8);
+
+    static_assert(sizeof(niche_result<int *>) == sizeof(int *));
+    static_assert(sizeof(niche_result<const double *>) == sizeof(double *));
+    static_assert(sizeof(inline_result<std::uint64_t *>) ==
+                  sizeof(std::uint64_t *));
+    static_assert(sizeof(niche_result<even_id>) == sizeof(even_id));
+
+    // no niche: char * may be odd, eBigError does not fit beside the tag
+    static_assert(sizeof(niche_result<char *>) == 2 * sizeof(char *));
+    static_assert(sizeof(niche_result<std::uint32_t>) ==
+                  2 * sizeof(std::uint32_t));
+    static_assert(sizeof(tricky::inline_result<int *, eBigError>) ==
+                  2 * sizeof(int *));
+}
+
+TEST(NicheResultTest, Pointers)
+{
+    const std::vector<int> values{1, 3, 4, 5};
+    const auto found = find_even(values);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(found.type_index(), 0);
+    ASSERT_EQ(found.value(), &values[2]);
+
+    const auto missing = find_even({1, 3});
+    ASSERT_TRUE(missing.has_error());
+    ASSERT_TRUE(missing.is_active_type<eReaderError>());
+    ASSERT_EQ(missing.error<eReaderError>(), eReaderError::kError2);
+
+    const niche_result<int *> null{nullptr};
+    ASSERT_TRUE(null);
+    ASSERT_EQ(null.value(), nullptr);
+
+    const niche_result<int *> defaulted;
+    ASSERT_TRUE(defaulted);
+    ASSERT_EQ(defaulted.value(), nullptr);
+}
+
+TEST(NicheResultTest, UserDefinedNiche)
+{
+    niche_result<even_id> r{even_id{42}};
+    ASSERT_TRUE(r);
+    ASSERT_EQ(r.value().value, 42);
+
+    r = niche_result<even_id>{eWriterError::kError4};
+    ASSERT_TRUE(r.is_active_type<eWriterError>());
+    ASSERT_EQ(r.error<eWriterError>(), eWriterError::kError4);
+}
+
+TEST(NicheResultTest, Conversion)
+{
+    tricky::inline_result<void, eWriterError> r{eWriterError::kError3};
+    niche_result<int *> r2(std::move(r));
+    ASSERT_TRUE(r2.is_active_type<eWriterError>());
+    ASSERT_EQ(r2.error<eWriterError>(), eWriterError::kError3);
+
+    inline_result<char> r3(std::move(r2));
+    ASSERT_TRUE(r3.is_active_type<eWriterError>());
+    ASSERT_EQ(r3.error<eWriterError>(), eWriterError::kError3);
+
+    int value{};
+    tricky::inline_result<int *, eReaderError> r4{&value};
+    niche_result<int *> r5(std::move(r4));
+    ASSERT_TRUE(r5);
+    ASSERT_EQ(r5.value(), &value);
+}
+
+TEST(NicheResultTest, Handlers)
+{
+    const auto process_error = tricky::handlers(
+        tricky::handler([](auto) noexcept -> const int * { return nullptr; }));
+
+    const std::vector<int> values{7, 8};
+    ASSERT_EQ(process_error(find_even(values)), &values[1]);
+    ASSERT_EQ(process_error(find_even({7, 9})), nullptr);
+}
+
+TEST(AnyErrorTest, Perform)
+{
+    using any_error_t = tricky::details::any_error<eReaderError, eWriterError,
+                                                   eBufferError, eFileError>;
+    constexpr auto to_int = [](auto aError) noexcept
+    { return static_cast<int>(aError); };
+
+    constexpr any_error_t kFileError{eFileError::kPermission};
+    static_assert(kFileError.perform(3, to_int) == 3);
+    static_assert(kFileError.get<3>() == eFileError::kPermission);
+
+    constexpr any_error_t kReaderError{eReaderError::kError2};
+    static_assert(kReaderError.perform(0, to_int) == 1);
+
+    const auto r = kFileError.make_result<short, eReaderError, eWriterError,
+                                          eBufferError, eFileError>(3);
+    ASSERT_TRUE(r.is_active_type<eFileError>());
+    ASSERT_EQ(r.error<eFileError>(), eFileError::kPermission);
+    tricky::shared_state::reset();
+}
+
+namespace
+{
+enum class eSparseError : std::int32_t
+{
+    kMin = std::numeric_limits<std::int32_t>::min(),
+    kZero = 0,
+    kTen = 10,
+    kThousand = 1000,
+    kUnhandled = 5000,
+    kMax = 0x7fff'ffff
+};
+
+using sparse_result = tricky::result<int, eReaderError, eSparseError>;
+
+using sparse_values =
+    tricky::details::sorted_values<eSparseError,
+                                   utils::value_list<eSparseError::kMax,
+                                                     eReaderError::kError1,
+                                                     eSparseError::kMin,
+                                                     eSparseError::kTen>>;
+}  // namespace
+
+TEST(SparseDispatchTest, SortedValues)
+{
+    static_assert(sparse_values::size == 3);
+    static_assert(sparse_values::values[0] ==
+                  std::numeric_limits<std::int32_t>::min());
+    static_assert(sparse_values::values[1] == 10);
+    static_assert(sparse_values::values[2] == 0x7fff'ffff);
+    static_assert(sparse_values::span == 0xffff'ffff);
+    static_assert(sparse_values::index_of(10) == 1);
+    static_assert(sparse_values::index_of(11) == sparse_values::size);
+}
+
+TEST(SparseDispatchTest, SourcesOfValues)
+{
+    using values = tricky::details::sorted_values<
+        eSparseError, utils::value_list<eSparseError::kTen>,
+        utils::value_list<eReaderError::kError1>,
+        utils::value_list<eSparseError::kMax, eSparseError::kMin>>;
+    static_assert(values::size == 3);
+    static_assert(values::sources[0] == 2);
+    static_assert(values::sources[1] == 0);
+    static_assert(values::sources[2] == 2);
+    static_assert(not values::contains_copies);
+    static_assert(tricky::details::sorted_values<
+                  eSparseError, utils::value_list<eSparseError::kTen>,
+                  utils::value_list<eSparseError::kTen>>::contains_copies);
+}
+
+TEST(SparseDispatchTest, ValueHandlers)
+{
+    const auto process_error = tricky::handlers(
+        tricky::handler<eSparseError::kMin>([]() noexcept { return 1; }),
+        tricky::handler<eSparseError::kZero, eSparseError::kThousand>(
+            [](auto aError) noexcept
+            { return aError == eSparseError::kZero ? 2 : 3; }),
+        tricky::handler<eSparseError::kMax>([]() noexcept { return 4; }),
+        tricky::handler<eSparseError>([](auto) noexcept { return 5; }),
+        tricky::handler([](auto) noexcept { return 6; }));
+
+    ASSERT_EQ(process_error(sparse_result{eSparseError::kMin}), 1);
+    ASSERT_EQ(process_error(sparse_result{eSparseError::kZero}), 2);
+    ASSERT_EQ(process_error(sparse_result{eSparseError::kThousand}), 3);
+    ASSERT_EQ(process_error(sparse_result{eSparseError::kMax}), 4);
+    ASSERT_EQ(process_error(sparse_result{eSparseError::kTen}), 5);
+    ASSERT_EQ(process_error(sparse_result{eSparseError::kUnhandled}), 5);
+    ASSERT_EQ(process_error(sparse_result{eReaderError::kError1}), 6);
+    ASSERT_EQ(process_error(sparse_result{7}), 7);
+    ASSERT_FALSE(tricky::shared_state::has_error());
+}
+
+TEST(SparseDispatchTest, PerfectHash)
+{
+    using hash = tricky::details::perfect_hash<sparse_values>;
+    static_assert(hash::kParams.found);
+    static_assert(hash::index_of(std::numeric_limits<std::int32_t>::min()) ==
+                  0);
+    static_assert(hash::index_of(10) == 1);
+    static_assert(hash::index_of(0x7fff'ffff) == 2);
+    static_assert(hash::index_of(0) == sparse_values::size);
+    static_assert(hash::index_of(11) == sparse_values::size);
+}
+
+TEST(SparseDispatchTest, StrategyDependsOnDensity)
+{
+    using tricky::details::value_dispatch;
+    using tricky::details::value_dispatch_v;
+    using dense_values = tricky::details::sorted_values<
+        eFileError, utils::value_list<eFileError::kOpenError, eFileError::kEOF,
+                                      eFileError::kSystemError>>;
+    static_assert(value_dispatch_v<dense_values> == value_dispatch::kTable);
+    static_assert(value_dispatch_v<sparse_values> ==
+                  value_dispatch::kPerfectHash);
+}
+
+TEST(TelemetryTest, DisabledByDefault)
+{
+    static_assert(!tricky::error_telemetry::enabled);
+    result<int> r = TRICKY_NEW_ERROR(eFileError::kEOF);
+    tricky::shared_state::reset();
+    ASSERT_EQ(tricky::error_telemetry::drain(
+                  [](const tricky::error_record &) noexcept {}),
+              0);
+}
+
+TEST(PayloadStatsTest, DisabledByDefault)
+{
+    static_assert(!tricky::kPayloadStats);
+    result<int> r{eFileError::kEOF, 1};
+    tricky::shared_state::reset();
+    ASSERT_EQ(tricky::shared_state::get_payload_stats().loads, 0);
+}
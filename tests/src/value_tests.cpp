@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include <tricky/tricky.h>
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "test_common.h"
+
+namespace
+{
+std::size_t g_allocations{};
+
+class allocation_counter
+{
+   public:
+    allocation_counter() noexcept : start_(g_allocations) {}
+
+    std::size_t count() const noexcept { return g_allocations - start_; }
+
+   private:
+    std::size_t start_;
+};
+}  // namespace
+
+void *operator new(std::size_t aSize)
+{
+    ++g_allocations;
+    if (void *ptr = std::malloc(aSize ? aSize : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *aPtr) noexcept { std::free(aPtr); }
+
+void operator delete(void *aPtr, std::size_t) noexcept { std::free(aPtr); }
+
+namespace
+{
+using namespace test_utils;
+
+template <typename T>
+using inline_result = tricky::inline_result<T, eReaderError, eWriterError,
+                                            eBufferError, eFileError>;
+
+using buffer_t = std::vector<char>;
+
+struct tracked
+{
+    static inline int alive{};
+    static inline int copies{};
+
+    explicit tracked(int aValue) noexcept : value(aValue) { ++alive; }
+    tracked(const tracked &aOther) noexcept : value(aOther.value)
+    {
+        ++alive;
+        ++copies;
+    }
+    tracked(tracked &&aOther) noexcept : value(aOther.value) { ++alive; }
+    tracked &operator=(const tracked &) noexcept = default;
+    tracked &operator=(tracked &&) noexcept = default;
+    ~tracked() { --alive; }
+
+    int value;
+};
+
+template <typename Result>
+Result read_buffer(std::size_t aSize) noexcept
+{
+    if (!aSize)
+    {
+        return eReaderError::kError1;
+    }
+    return Result(std::in_place, aSize, 'x');
+}
+
+template <typename Result>
+Result read_twice(std::size_t aSize) noexcept
+{
+    TRICKY_AUTO(buffer, read_buffer<Result>(aSize));
+    buffer.push_back('!');
+    return buffer;
+}
+
+template <typename Result>
+class ValueTest : public ::testing::Test
+{
+};
+
+using result_types =
+    ::testing::Types<result<buffer_t>, inline_result<buffer_t>>;
+TYPED_TEST_SUITE(ValueTest, result_types);
+}  // namespace
+
+TYPED_TEST(ValueTest, ReturnBufferWithoutExtraAllocations)
+{
+    const allocation_counter counter;
+    TypeParam r = read_buffer<TypeParam>(64);
+    ASSERT_EQ(counter.count(), 1);
+    ASSERT_TRUE(r);
+    ASSERT_EQ(r.value().size(), 64);
+
+    const buffer_t buffer = std::move(r).value();
+    ASSERT_EQ(buffer.size(), 64);
+    ASSERT_EQ(counter.count(), 1);
+}
+
+TYPED_TEST(ValueTest, PropagateBufferWithoutExtraAllocations)
+{
+    const allocation_counter counter;
+    const auto r = read_twice<TypeParam>(3);
+    // the buffer grows once on push_back
+    ASSERT_EQ(counter.count(), 2);
+    ASSERT_TRUE(r);
+    ASSERT_EQ(r.value(), (buffer_t{'x', 'x', 'x', '!'}));
+}
+
+TYPED_TEST(ValueTest, ErrorDoesNotAllocate)
+{
+    const allocation_counter counter;
+    TypeParam r = read_twice<TypeParam>(0);
+    ASSERT_TRUE(r.has_error());
+    ASSERT_TRUE(r.template is_active_type<eReaderError>());
+    ASSERT_EQ(counter.count(), 0);
+    tricky::shared_state::reset();
+}
+
+TYPED_TEST(ValueTest, CopyAndAssign)
+{
+    TypeParam r{buffer_t{'a', 'b'}};
+    TypeParam copy = r;
+    ASSERT_EQ(copy.value(), r.value());
+
+    TypeParam other{eWriterError::kError4};
+    tricky::shared_state::reset();
+    other = r;
+    ASSERT_TRUE(other);
+    ASSERT_EQ(other.value(), (buffer_t{'a', 'b'}));
+
+    other = TypeParam{eFileError::kEOF};
+    ASSERT_TRUE(other.template is_active_type<eFileError>());
+    tricky::shared_state::reset();
+}
+
+TEST(ValueTest, MoveOnlyValue)
+{
+    using ptr_t = std::unique_ptr<int>;
+    inline_result<ptr_t> r{std::make_unique<int>(5)};
+    ASSERT_TRUE(r);
+    ASSERT_EQ(*r.value(), 5);
+
+    inline_result<ptr_t> moved = std::move(r);
+    ASSERT_EQ(*moved.value(), 5);
+
+    static_assert(!std::is_copy_constructible_v<inline_result<ptr_t>>);
+    static_assert(!std::is_copy_assignable_v<inline_result<ptr_t>>);
+    static_assert(std::is_nothrow_move_constructible_v<inline_result<ptr_t>>);
+
+    const ptr_t ptr = std::move(moved).value();
+    ASSERT_EQ(*ptr, 5);
+
+    tricky::result<ptr_t, eFileError> shared{std::in_place, new int{7}};
+    ASSERT_EQ(*shared.value(), 7);
+}
+
+TEST(ValueTest, ConversionMovesValue)
+{
+    tricky::inline_result<std::string, eFileError> r{std::string(64, 's')};
+    const char *data = r.value().data();
+    inline_result<std::string> converted(std::move(r));
+    ASSERT_TRUE(converted);
+    ASSERT_EQ(converted.value().data(), data);
+}
+
+TEST(ValueTest, DestructorRunsForActiveMemberOnly)
+{
+    {
+        inline_result<tracked> r{std::in_place, 1};
+        ASSERT_EQ(tracked::alive, 1);
+
+        inline_result<tracked> e{eBufferError::kInvalidIndex};
+        ASSERT_EQ(tracked::alive, 1);
+
+        r = e;
+        ASSERT_EQ(tracked::alive, 0);
+
+        e = inline_result<tracked>{std::in_place, 2};
+        ASSERT_EQ(tracked::alive, 1);
+    }
+    ASSERT_EQ(tracked::alive, 0);
+    ASSERT_EQ(tracked::copies, 0);
+}